@@ -0,0 +1,60 @@
+#include "Checkpoint.h"
+
+namespace {
+    const char MAGIC[4] = {'R', 'W', 'C', 'P'};
+    const uint32_t FORMAT = 1;
+}
+
+Checkpoint::Checkpoint(std::string path, std::chrono::seconds interval) : path(std::move(path)), interval(interval), last(std::chrono::steady_clock::now()) {}
+
+const std::string &Checkpoint::getPath() const {
+    return path;
+}
+
+bool Checkpoint::due() {
+    std::lock_guard<std::mutex> guard(lock);
+    auto now = std::chrono::steady_clock::now();
+    if (now - last < interval) return false;
+    last = now;
+    return true;
+}
+
+bool Checkpoint::load(uint64_t key, vec<long long> &state) const {
+    std::ifstream file(path, std::ios::binary);
+    Header header{};
+    if (!file.read((char*) &header, sizeof(header))) return false;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format != FORMAT || header.key != key) return false;
+
+    state.resize(header.count);
+    return (bool) file.read((char*) state.data(), (std::streamsize) (state.size() * sizeof(long long)));
+}
+
+bool Checkpoint::save(uint64_t key, const vec<long long> &state) const {
+    TraceScope scope("checkpoint");
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file) return false;
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.format = FORMAT;
+        header.key = key;
+        header.count = state.size();
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) state.data(), (std::streamsize) (state.size() * sizeof(long long)));
+        if (!file.flush()) return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void Checkpoint::remove() const {
+    std::remove(path.c_str());
+}
+
+uint64_t Checkpoint::key(std::initializer_list<uint64_t> values) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t v : values)
+        for (int i = 0; i < 8; i++) hash = (hash ^ (v >> (8 * i) & 0xFF)) * 1099511628211ULL;
+    return hash;
+}
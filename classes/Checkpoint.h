@@ -0,0 +1,115 @@
+#ifndef RAILWAYS_CHECKPOINT_H
+#define RAILWAYS_CHECKPOINT_H
+
+#include "StationLink.h"
+#include "Trace.h"
+
+/**
+ * @brief Checkpoint class
+ *
+ * @details Small file where a long sweep keeps its iteration state, so a run that crashes or is stopped can resume
+ * from the last save instead of from the beginning.
+ * The state is a list of integers whose meaning is up to the sweep. It is saved with a key identifying the sweep
+ * (its kind, its parameters and the network it runs on), and only loaded back for the same key.
+ * The file is a 24-byte header (magic "RWCP", format version, key, number of values) followed by the values as
+ * native 64-bit integers. It is written to a temporary file and renamed over the old one, so a crash while saving
+ * leaves the previous checkpoint intact.
+ */
+class Checkpoint {
+private:
+
+    /**
+     * @brief File header
+     */
+    struct Header {
+        char magic[4];
+        uint32_t format;
+        uint64_t key;
+        uint64_t count;
+    };
+
+    /**
+     * @brief Checkpoint file
+     */
+    std::string path;
+
+    /**
+     * @brief Least time between two saves
+     */
+    std::chrono::steady_clock::duration interval;
+
+    /**
+     * @brief Time of the last save (or of the construction)
+     */
+    std::chrono::steady_clock::time_point last;
+
+    /**
+     * @brief Keeps due thread-safe
+     */
+    std::mutex lock;
+
+public:
+
+    /**
+     * @brief Checkpoint Constructor
+     *
+     * @param path Checkpoint file
+     * @param interval Least time between two saves
+     */
+    explicit Checkpoint(std::string path, std::chrono::seconds interval = std::chrono::seconds(30));
+
+    /**
+     * @brief Get Path
+     *
+     * @return Checkpoint file
+     */
+    const std::string &getPath() const;
+
+    /**
+     * @brief Due
+     *
+     * @return true if the interval has passed since the last save, at most once per interval
+     *
+     * @details It can be called from any thread.
+     */
+    bool due();
+
+    /**
+     * @brief Load
+     *
+     * @param key Key of the sweep
+     * @param state Set to the saved state
+     *
+     * @return true if the file holds a state saved with the same key
+     */
+    bool load(uint64_t key, vec<long long> &state) const;
+
+    /**
+     * @brief Save
+     *
+     * @param key Key of the sweep
+     * @param state State to save
+     *
+     * @return true if the state was saved
+     */
+    bool save(uint64_t key, const vec<long long> &state) const;
+
+    /**
+     * @brief Remove
+     *
+     * @details Removes the file, once the sweep is complete.
+     */
+    void remove() const;
+
+    /**
+     * @brief Key
+     *
+     * @param values Values identifying a sweep
+     *
+     * @return Hash of the values, in order
+     */
+    static uint64_t key(std::initializer_list<uint64_t> values);
+};
+
+
+#endif //RAILWAYS_CHECKPOINT_H
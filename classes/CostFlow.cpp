@@ -0,0 +1,160 @@
+#include "CostFlow.h"
+
+namespace {
+    /**
+     * @brief Factor epsilon is divided by in each phase of cost scaling
+     */
+    const int SCALING_FACTOR = 16;
+
+    /**
+     * @brief Bound on how far prices move during cost scaling, in multiples of V times the first epsilon
+     */
+    const int PRICE_RANGE = 8;
+}
+
+template<typename Cap, typename Cost>
+CostFlowGraph<Cap, Cost>::CostFlowGraph(int _n) : n(_n), adj(_n), potential(_n, 0) {}
+
+template<typename Cap, typename Cost>
+int CostFlowGraph<Cap, Cost>::addArc(int u, int v, Cap capacity, Cost _cost) {
+    int e = (int) head.size();
+    head.push_back(v); residual.push_back(capacity); cost.push_back(_cost);
+    head.push_back(u); residual.push_back(0); cost.push_back(-_cost);
+    adj[u].push_back(e); adj[v].push_back(e ^ 1);
+    return e;
+}
+
+template<typename Cap, typename Cost>
+Cap CostFlowGraph<Cap, Cost>::getFlow(int e) const {
+    return residual[e ^ 1];
+}
+
+template<typename Cap, typename Cost>
+Cost CostFlowGraph<Cap, Cost>::successiveShortestPaths(int src, int dest, const std::function<Cap(Cap, Cost)> &step) {
+    TraceScope scope("successive shortest paths");
+    const Cost INF = std::numeric_limits<Cost>::max();
+    Cost total = 0;
+    vec<Cost> dist(n);
+    vec<int> parent(n);
+
+    while (true) {
+        TraceScope round("dijkstra");
+        std::fill(dist.begin(), dist.end(), INF);
+        std::fill(parent.begin(), parent.end(), -1);
+        std::priority_queue<std::pair<Cost, int>, vec<std::pair<Cost, int>>, std::greater<>> pq;
+        dist[src] = 0;
+        pq.emplace(0, src);
+
+        while (!pq.empty()) {
+            auto [d, u] = pq.top(); pq.pop();
+            if (d > dist[u]) continue;
+            for (int e : adj[u]) {
+                if (residual[e] == 0) continue;
+                int w = head[e];
+                Cost nd = d + cost[e] + potential[u] - potential[w];
+                if (nd < dist[w]) {
+                    dist[w] = nd;
+                    parent[w] = e;
+                    pq.emplace(nd, w);
+                }
+            }
+        }
+        if (dist[dest] == INF) break;
+
+        for (int v = 0; v < n; v++) if (dist[v] != INF) potential[v] += dist[v];
+
+        Cap bottleneck = std::numeric_limits<Cap>::max();
+        for (int v = dest; v != src; v = head[parent[v] ^ 1]) bottleneck = std::min(bottleneck, residual[parent[v]]);
+
+        Cap flow = step(bottleneck, potential[dest] - potential[src]);
+        if (flow <= 0) break;
+
+        TraceScope update("update path");
+        for (int v = dest; v != src; v = head[parent[v] ^ 1]) {
+            residual[parent[v]] -= flow;
+            residual[parent[v] ^ 1] += flow;
+        }
+        total += flow * (potential[dest] - potential[src]);
+    }
+
+    return total;
+}
+
+template<typename Cap, typename Cost>
+Cost CostFlowGraph<Cap, Cost>::costScaling(int src, int dest, Cap &flow) {
+    TraceScope scope("cost scaling");
+    flow = 0;
+    if (src == dest) return 0;
+
+    int m = (int) head.size();
+    Cost largest = 0;
+    Cap out = 0; // no more can leave src
+    for (int e = 0; e < m; e += 2) largest = std::max(largest, cost[e]);
+
+    // the back arc costs about V * C, scaling multiplies it by V + 1, and prices can move a few V times epsilon
+    __int128 bound = ((__int128) n * largest + 1) * (n + 1) * PRICE_RANGE * (n + 1);
+    if (bound > (__int128) std::numeric_limits<Cost>::max()) {
+        return successiveShortestPaths(src, dest, [&](Cap bottleneck, Cost) { flow += bottleneck; return bottleneck; });
+    }
+    for (int e : adj[src]) if (!(e & 1)) out = (Cap) std::min<long long>((long long) out + residual[e], std::numeric_limits<Cap>::max());
+    int back = addArc(dest, src, out, -(Cost) n * largest - 1);
+
+    vec<Cost> scaled(cost.size());
+    Cost epsilon = 0;
+    for (int e = 0; e < (int) cost.size(); e++) {
+        scaled[e] = cost[e] * (n + 1);
+        epsilon = std::max(epsilon, std::abs(scaled[e]));
+    }
+
+    vec<Cost> price(n, 0);
+    vec<Cap> excess(n, 0);
+    vec<int> current(n);
+    auto reduced = [&](int e) { return scaled[e] + price[head[e ^ 1]] - price[head[e]]; };
+    auto push = [&](int e, Cap amount) {
+        residual[e] -= amount; residual[e ^ 1] += amount;
+        excess[head[e ^ 1]] -= amount; excess[head[e]] += amount;
+    };
+
+    while (epsilon > 1) {
+        TraceScope phase("refine");
+        epsilon = std::max<Cost>(1, epsilon / SCALING_FACTOR);
+        for (int e = 0; e < (int) head.size(); e++)
+            if (residual[e] > 0 && reduced(e) < 0) push(e, residual[e]);
+
+        std::queue<int> active;
+        for (int v = 0; v < n; v++) {
+            current[v] = 0;
+            if (excess[v] > 0) active.push(v);
+        }
+
+        while (!active.empty()) {
+            int u = active.front(); active.pop();
+            while (excess[u] > 0) {
+                if (current[u] == (int) adj[u].size()) { // relabel
+                    Cost best = std::numeric_limits<Cost>::min();
+                    for (int e : adj[u]) if (residual[e] > 0) best = std::max(best, price[head[e]] - scaled[e]);
+                    price[u] = best - epsilon;
+                    current[u] = 0;
+                    continue;
+                }
+                int e = adj[u][current[u]];
+                if (residual[e] == 0 || reduced(e) >= 0) { current[u]++; continue; }
+                int v = head[e];
+                bool wasActive = excess[v] > 0;
+                push(e, std::min(excess[u], residual[e]));
+                if (!wasActive && excess[v] > 0) active.push(v);
+            }
+        }
+    }
+
+    flow = residual[back ^ 1];
+    Cost total = 0;
+    for (int e = 0; e < m; e += 2) total += residual[e ^ 1] * cost[e];
+
+    for (int i = 0; i < 2; i++) head.pop_back(), residual.pop_back(), cost.pop_back();
+    adj[dest].pop_back(); adj[src].pop_back();
+    return total;
+}
+
+template class CostFlowGraph<int, long long>;
+template class CostFlowGraph<long long, long long>;
@@ -0,0 +1,123 @@
+#ifndef RAILWAYS_COSTFLOW_H
+#define RAILWAYS_COSTFLOW_H
+
+#include "StationLink.h"
+#include "Trace.h"
+
+/**
+ * @brief Cost Flow Graph class
+ *
+ * @details Directed graph with a capacity and a cost per unit of flow on every arc, for min-cost flow problems.
+ * Every arc added gets a residual arc right after it, so the residual of arc e is always e ^ 1.
+ *
+ * @tparam Cap Capacity type
+ * @tparam Cost Cost type, also used for path costs and potentials
+ */
+template<typename Cap = int, typename Cost = long long>
+class CostFlowGraph {
+private:
+
+    /**
+     * @brief Number of vertices
+     */
+    int n;
+
+    /**
+     * @brief Destination vertex of each arc
+     */
+    vec<int> head;
+
+    /**
+     * @brief Residual capacity of each arc
+     */
+    vec<Cap> residual;
+
+    /**
+     * @brief Cost per unit of flow of each arc
+     */
+    vec<Cost> cost;
+
+    /**
+     * @brief Arcs leaving each vertex
+     */
+    vec<vec<int>> adj;
+
+    /**
+     * @brief Potential of each vertex, keeping the reduced costs of the residual arcs non-negative
+     */
+    vec<Cost> potential;
+
+public:
+
+    /**
+     * @brief Cost Flow Graph Constructor
+     *
+     * @param n Number of vertices
+     *
+     * @details Creates a graph with n vertices and no arcs
+     */
+    explicit CostFlowGraph(int n);
+
+    /**
+     * @brief Add Arc
+     *
+     * @param u Source vertex
+     * @param v Destination vertex
+     * @param capacity Arc capacity
+     * @param cost Cost per unit of flow
+     *
+     * @return Id of the arc
+     *
+     * @details Adds an arc and its residual arc. Costs must not be negative. This function has Complexity O(1).
+     */
+    int addArc(int u, int v, Cap capacity, Cost cost);
+
+    /**
+     * @brief Get Flow
+     *
+     * @param e Arc
+     *
+     * @return Flow on the arc
+     */
+    Cap getFlow(int e) const;
+
+    /**
+     * @brief Successive Shortest Paths
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param step Called before every augmentation with the bottleneck of the cheapest path and its cost per unit,
+     * returns how much flow to push through it (0 stops)
+     *
+     * @return Total cost of the flow sent
+     *
+     * @details Sends flow from src to dest along cheapest residual paths, found with Dijkstra over reduced costs.
+     * The cost per unit of the paths never decreases, so the steps trace the piecewise-linear curve of the min cost of
+     * each flow value. This function has Complexity O(P * E log(V)) where P is the number of augmentations.
+     */
+    Cost successiveShortestPaths(int src, int dest, const std::function<Cap(Cap, Cost)> &step);
+
+    /**
+     * @brief Cost Scaling
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param flow Filled with the max flow from src to dest
+     *
+     * @return Min cost of sending the max flow from src to dest
+     *
+     * @details Goldberg-Tarjan cost scaling. A temporary arc from dest back to src, cheaper than any path is costly,
+     * turns the problem into a min-cost circulation, which is solved by push-relabel over epsilon-optimal prices:
+     * every phase divides epsilon, saturates the arcs of negative reduced cost and pushes the excess they leave
+     * along admissible arcs until none is left. The number of phases grows with the log of the largest cost, not with
+     * the flow or the number of distinct path costs, so it stays fast with wide cost ranges, where successive shortest
+     * paths needs one Dijkstra per augmentation. Costs are scaled by V + 1, so the last phase (epsilon 1) is optimal.
+     * The graph must have no flow yet, and is left with the flow found. When the scaled costs and prices could overflow
+     * the cost type (about V^3 C), the flow is found with successiveShortestPaths instead.
+     * This function has Complexity O(V^2 E log(VC)) where C is the largest cost.
+     */
+    Cost costScaling(int src, int dest, Cap &flow);
+};
+
+
+#endif //RAILWAYS_COSTFLOW_H
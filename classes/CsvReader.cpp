@@ -0,0 +1,154 @@
+#include "CsvReader.h"
+
+namespace {
+    /**
+     * @brief Smallest range worth a thread of its own, in bytes
+     */
+    const size_t MIN_CHUNK = 1 << 20;
+
+    /**
+     * @brief Next field of a row, moving the row past it
+     */
+    std::string_view field(std::string_view &line) {
+        size_t comma = line.find(',');
+        auto f = line.substr(0, comma);
+        line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+        return f;
+    }
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && isspace(s.front())) s.remove_prefix(1);
+        while (!s.empty() && isspace(s.back())) s.remove_suffix(1);
+        return s;
+    }
+
+    /**
+     * @brief Parses the whole cell as a number that is not negative, leaving value as it was if it is not one
+     */
+    template<typename T>
+    bool nonNegative(std::string_view cell, T &value) {
+        T parsed;
+        auto [end, ec] = std::from_chars(cell.data(), cell.data() + cell.size(), parsed);
+        if (ec != std::errc() || end != cell.data() + cell.size() || parsed < 0) return false;
+        value = parsed;
+        return true;
+    }
+
+    std::string upper(std::string_view s) {
+        std::string ans(s);
+        std::transform(ans.begin(), ans.end(), ans.begin(), ::toupper);
+        return ans;
+    }
+}
+
+bool CsvReader::readFile(const std::string &path, std::string &content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.seekg(0, std::ios::end);
+    content.resize((size_t) file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read(&content[0], (std::streamsize) content.size());
+    return (bool) file;
+}
+
+vec<std::pair<size_t, size_t>> CsvReader::split(const std::string &content, size_t from, int chunks) {
+    vec<std::pair<size_t, size_t>> ranges;
+    size_t size = content.size() - from, step = size / chunks + 1;
+
+    for (size_t begin = from; begin < content.size(); ) {
+        size_t end = content.find('\n', std::min(begin + step, content.size()) - 1);
+        end = end == std::string::npos ? content.size() : end + 1;
+        ranges.emplace_back(begin, end);
+        begin = end;
+    }
+    return ranges;
+}
+
+vec<CsvReader::Column> CsvReader::columns(std::string_view header) {
+    header = trim(header);
+    for (int i = 0; i < 4; i++) field(header); // stations, capacity and service
+
+    vec<Column> ans;
+    while (!header.empty()) {
+        auto name = upper(trim(field(header)));
+        ans.push_back(name == "DISTANCE" ? DISTANCE_COLUMN : name == "ENERGY" ? ENERGY_COLUMN : name == "COST" ? COST_COLUMN : OTHER_COLUMN);
+    }
+    return ans;
+}
+
+CsvReader::RowError CsvReader::parseLink(std::string_view line, const std::unordered_map<std::string, ptr<Station>> &index, const vec<Column> &extra, LinkRecord &record) {
+    auto a = index.find(upper(field(line)));
+    auto b = index.find(upper(field(line)));
+    if (a == index.end() || b == index.end()) return UNKNOWN_STATION;
+    record.src = a->second;
+    record.dest = b->second;
+
+    auto capacity = field(line);
+    while (!capacity.empty() && isspace(capacity.front())) capacity.remove_prefix(1);
+    record.capacity = 0;
+    std::from_chars(capacity.data(), capacity.data() + capacity.size(), record.capacity);
+
+    auto service = field(line);
+    while (!service.empty() && isspace(service.front())) service.remove_prefix(1);
+    while (!service.empty() && isspace(service.back())) service.remove_suffix(1);
+    record.service = service == "STANDARD" ? STANDARD : PENDULAR;
+
+    for (auto column : extra) {
+        if (line.empty()) break;
+        auto value = trim(field(line));
+        if (value.empty()) continue;
+        bool valid = column == COST_COLUMN ? nonNegative(value, record.cost)
+                   : column == DISTANCE_COLUMN ? nonNegative(value, record.distance)
+                   : column == ENERGY_COLUMN ? nonNegative(value, record.energy) : true;
+        if (!valid) return INVALID_VALUE;
+    }
+    return NO_ERROR;
+}
+
+bool CsvReader::readLinks(const std::string &path, const std::unordered_map<std::string, ptr<Station>> &index, vec<LinkRecord> &records) {
+    std::string content;
+    {
+        TraceScope scope("read file");
+        if (!readFile(path, content)) return false;
+    }
+
+    size_t header = content.find('\n');
+    header = header == std::string::npos ? content.size() : header + 1;
+    auto extra = columns(std::string_view(content.data(), header));
+    int chunks = (int) std::max<size_t>(1, std::min<size_t>(workerCount(), (content.size() - header) / MIN_CHUNK));
+    auto ranges = split(content, header, chunks);
+
+    vec<vec<LinkRecord>> parsed(ranges.size());
+    vec<std::string> invalid(ranges.size()); // first row that could not be parsed in each range
+    vec<RowError> errors(ranges.size(), NO_ERROR);
+
+    parallelFor((int) ranges.size(), [&](int i, int) {
+        TraceScope scope("parse range");
+        std::string_view text(content.data() + ranges[i].first, ranges[i].second - ranges[i].first);
+
+        while (!text.empty()) {
+            size_t eol = text.find('\n');
+            auto line = text.substr(0, eol);
+            text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line.empty()) continue;
+
+            LinkRecord record;
+            if ((errors[i] = parseLink(line, index, extra, record)) != NO_ERROR) { invalid[i] = line; return; }
+            parsed[i].push_back(std::move(record));
+        }
+    });
+
+    TraceScope scope("merge ranges");
+    records.clear();
+    size_t total = 0;
+    for (auto &p : parsed) total += p.size();
+    records.reserve(total);
+
+    for (int i = 0; i < (int) ranges.size(); i++) {
+        if (errors[i] == UNKNOWN_STATION) throw std::out_of_range("Unknown station in row: " + invalid[i]);
+        if (errors[i] == INVALID_VALUE) throw std::invalid_argument("Negative or invalid distance, energy or cost in row: " + invalid[i]);
+        for (auto &r : parsed[i]) records.push_back(std::move(r));
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef RAILWAYS_CSVREADER_H
+#define RAILWAYS_CSVREADER_H
+
+#include "StationLink.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+/**
+ * @brief Csv Reader class
+ *
+ * @details Parallel reader for the network files. The file is read at once and split into byte ranges that end at
+ * line breaks, each range is parsed by a different thread, and the rows of the ranges are joined back in file order,
+ * so the result is the same as reading the file line by line.
+ */
+class CsvReader {
+private:
+
+    /**
+     * @brief Optional columns of the network file, after the service
+     */
+    enum Column {
+        OTHER_COLUMN,
+        DISTANCE_COLUMN,
+        ENERGY_COLUMN,
+        COST_COLUMN
+    };
+
+    /**
+     * @brief What is wrong with a row of the network file
+     */
+    enum RowError {
+        NO_ERROR,
+        UNKNOWN_STATION,
+        INVALID_VALUE
+    };
+
+    /**
+     * @brief Read File
+     *
+     * @param path File to read
+     * @param content String to fill
+     *
+     * @return true if the file was read
+     */
+    static bool readFile(const std::string &path, std::string &content);
+
+    /**
+     * @brief Split
+     *
+     * @param content File content
+     * @param from Position where the rows start
+     * @param chunks Number of ranges wanted
+     *
+     * @return Ranges [begin, end) of the content, each ending right after a line break (or at the end of the content)
+     *
+     * @details This function has Complexity O(chunks + L) where L is the length of the longest line.
+     */
+    static vec<std::pair<size_t, size_t>> split(const std::string &content, size_t from, int chunks);
+
+    /**
+     * @brief Columns
+     *
+     * @param header Header row of the network file
+     *
+     * @return Kind of every column after the service, from its name (Distance, Energy or Cost, in any case and order)
+     */
+    static vec<Column> columns(std::string_view header);
+
+    /**
+     * @brief Parse Link
+     *
+     * @param line Row of the network file, without its line break
+     * @param index Station of each name, in upper case
+     * @param extra Kind of every column after the service
+     * @param record Record to fill
+     *
+     * @return NO_ERROR, UNKNOWN_STATION if a station of the row is not in the index, or INVALID_VALUE if a distance,
+     * energy or cost is negative or not a number
+     */
+    static RowError parseLink(std::string_view line, const std::unordered_map<std::string, ptr<Station>> &index, const vec<Column> &extra, LinkRecord &record);
+
+public:
+
+    /**
+     * @brief Read Links
+     *
+     * @param path Network file (Station_A,Station_B,Capacity,Service with a header row, optionally followed by
+     * Distance, Energy and Cost columns in any order; empty or missing values keep the defaults of LinkRecord)
+     * @param index Station of each name, in upper case
+     * @param records Vector to fill with the rows, in file order
+     *
+     * @return false if the file could not be opened
+     *
+     * @details Parses the file over workerCount() threads. The index is only read while parsing, so every thread
+     * resolves names through it at the same time without locking. Blank lines are skipped.
+     * This function has Complexity O(N / T) where N is the size of the file and T is the number of threads.
+     *
+     * @throws std::out_of_range if a row names a station that is not in the index
+     * @throws std::invalid_argument if a row has a distance, energy or cost that is negative or not a number
+     */
+    static bool readLinks(const std::string &path, const std::unordered_map<std::string, ptr<Station>> &index, vec<LinkRecord> &records);
+};
+
+
+#endif //RAILWAYS_CSVREADER_H
@@ -0,0 +1,549 @@
+#include "FlowGraph.h"
+
+namespace {
+    /**
+     * @brief Smallest graph, in vertices, searched with levelSearch
+     */
+    const int LEVEL_SEARCH_VERTICES = 1 << 16;
+
+    /**
+     * @brief Smallest level, in vertices, expanded in parallel
+     */
+    const int PARALLEL_LEVEL = 4096;
+
+    /**
+     * @brief Vertices per parallel task (a multiple of 64, so every bitmap word belongs to one task in bottom-up steps)
+     */
+    const int LEVEL_CHUNK = 1024;
+
+    /**
+     * @brief Direction switches: bottom-up once the frontier has more than 1 / ALPHA of the unexplored arcs, top-down
+     * again once it has less than 1 / BETA of the vertices
+     */
+    const long long ALPHA = 14, BETA = 24;
+
+    /**
+     * @brief Starts a new search in the scratch, clearing the marks of old searches when the stamp wraps around
+     */
+    template<typename Cap>
+    unsigned int nextSearch(FlowScratch<Cap> &scratch) {
+        if (++scratch.stamp == 0) {
+            std::fill(scratch.seen.begin(), scratch.seen.end(), 0);
+            std::fill(scratch.seenFromDest.begin(), scratch.seenFromDest.end(), 0);
+            scratch.stamp = 1;
+        }
+        return scratch.stamp;
+    }
+
+    bool testBit(const vec<uint64_t> &bits, int v) {
+        return bits[v >> 6] >> (v & 63) & 1;
+    }
+
+    /**
+     * @brief Sets a bit shared with other threads, returning whether it was clear
+     */
+    bool claimBit(vec<uint64_t> &bits, int v) {
+        uint64_t bit = 1ULL << (v & 63);
+        std::atomic_ref<uint64_t> word(bits[v >> 6]);
+        return !(word.load(std::memory_order_relaxed) & bit) && !(word.fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+}
+
+long long residualBound(const vec<ptr<Link>> &links) {
+    long long bound = 0;
+    for (auto &l : links) bound = std::max(bound, 2LL * l->getCapacity());
+    return bound;
+}
+
+template<typename Cap>
+FlowGraph<Cap>::FlowGraph(const vec<ptr<Station>> &_stations, const vec<ptr<Link>> &_links, bool withSuperSource) {
+    TraceScope scope("snapshot");
+    for (auto &s : _stations) {
+        index[s->getId()] = (int) vertices.size();
+        vertices.push_back(s);
+    }
+
+    std::unordered_set<Link*> added;
+    for (auto &l : _links) {
+        auto rev = l->getReverse();
+        if (added.count(l.get()) || !index.count(l->getSrc()->getId()) || !index.count(l->getDest()->getId())) continue;
+        added.insert(l.get()); added.insert(rev.get());
+
+        for (auto &a : {l, rev}) {
+            head.push_back(index.at(a->getDest()->getId()));
+            bool enabled = a->isEnabled() && a->getSrc()->isEnabled() && a->getDest()->isEnabled();
+            capacity.push_back(enabled ? (Cap) a->getCapacity() : 0);
+            arcIndex[a.get()] = (int) arcs.size();
+            arcs.push_back(a);
+        }
+    }
+
+    n = (int) vertices.size();
+    sourceArc.assign(n, -1);
+
+    if (withSuperSource) {
+        superSource = n++;
+        vertices.push_back(nullptr);
+        sourceArc.push_back(-1);
+
+        for (int v = 0; v < superSource; v++) {
+            if (vertices[v]->getLinks().size() != 1) continue;
+            sourceArc[v] = (int) head.size();
+            for (int to : {v, superSource}) {
+                head.push_back(to);
+                capacity.push_back(std::numeric_limits<Cap>::max() / 2); // unbounded, the source link is the limit
+                arcs.push_back(nullptr);
+            }
+        }
+    }
+
+    first.assign(n + 1, 0);
+    for (int e = 0; e < (int) head.size(); e++) first[head[e ^ 1] + 1]++;
+    for (int v = 0; v < n; v++) first[v + 1] += first[v];
+
+    adj.resize(head.size());
+    vec<int> pos(first.begin(), first.end() - 1);
+    for (int e = 0; e < (int) head.size(); e++) adj[pos[head[e ^ 1]]++] = e;
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::size() const {
+    return n;
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::arcCount() const {
+    return (int) head.size();
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::vertex(const ptr<Station> &s) const {
+    auto it = index.find(s->getId());
+    return it == index.end() ? -1 : it->second;
+}
+
+template<typename Cap>
+ptr<Station> FlowGraph<Cap>::station(int v) const {
+    return vertices[v];
+}
+
+template<typename Cap>
+ptr<Link> FlowGraph<Cap>::link(int e) const {
+    return arcs[e];
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::arc(const ptr<Link> &link) const {
+    auto it = arcIndex.find(link.get());
+    return it == arcIndex.end() ? -1 : it->second;
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::getHead(int e) const {
+    return head[e];
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::getTail(int e) const {
+    return head[e ^ 1];
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::getCapacity(int e) const {
+    return capacity[e];
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::getSuperSource() const {
+    return superSource;
+}
+
+template<typename Cap>
+int FlowGraph<Cap>::getSourceArc(int v) const {
+    return sourceArc[v];
+}
+
+template<typename Cap>
+vec<int> FlowGraph<Cap>::getSinkArcs(int sink) const {
+    if (sourceArc[sink] == -1) return {};
+    return {sourceArc[sink]};
+}
+
+template<typename Cap>
+void FlowGraph<Cap>::removeArcs(const vec<int> &arcs, Scratch &scratch) const {
+    for (int e : arcs) scratch.residual[e] = scratch.residual[e ^ 1] = 0;
+}
+
+template<typename Cap>
+void FlowGraph<Cap>::reset(Scratch &scratch) const {
+    TraceScope scope("reset");
+    scratch.residual.assign(capacity.begin(), capacity.end());
+
+    scratch.parent.assign(n, -1);
+    scratch.child.assign(n, -1);
+    scratch.queue.resize(n);
+    scratch.seen.assign(n, 0);
+    scratch.seenFromDest.assign(n, 0);
+    scratch.stamp = 0;
+    scratch.delta = 1;
+    scratch.augmentations = 0;
+    scratch.excess.assign(n, 0);
+}
+
+template<typename Cap>
+void FlowGraph<Cap>::reset(Scratch &scratch, const Scenario &scenario) const {
+    reset(scratch);
+    TraceScope scope("scenario");
+
+    vec<const Scenario*> chain; // oldest base first
+    for (auto s = &scenario; s; s = s->getBase().get()) chain.push_back(s);
+    std::reverse(chain.begin(), chain.end());
+
+    for (auto s : chain) {
+        for (auto &[l, c] : s->getCapacities()) {
+            int e = arc(l);
+            if (e != -1 && capacity[e] != 0) scratch.residual[e] = scratch.residual[e ^ 1] = (Cap) c; // disabled arcs stay disabled
+        }
+    }
+    for (auto s : chain) {
+        for (auto &st : s->getStations()) {
+            int v = vertex(st);
+            if (v == -1) continue;
+            for (int i = first[v]; i < first[v + 1]; i++) scratch.residual[adj[i]] = scratch.residual[adj[i] ^ 1] = 0;
+        }
+        for (auto &l : s->getLinks()) {
+            int e = arc(l);
+            if (e != -1) scratch.residual[e] = scratch.residual[e ^ 1] = 0;
+        }
+    }
+}
+
+template<typename Cap>
+template<typename F>
+int FlowGraph<Cap>::search(int src, F isTarget, Scratch &scratch) const {
+    TraceScope scope("bfs");
+    unsigned int stamp = nextSearch(scratch);
+    Cap delta = scratch.delta;
+    if (n >= LEVEL_SEARCH_VERTICES && workerCount() > 1 && !insideParallelFor) return levelSearch(src, isTarget, scratch);
+
+    int front = 0, back = 0;
+    scratch.queue[back++] = src;
+    scratch.seen[src] = stamp;
+    scratch.parent[src] = -1;
+
+    while (front < back) {
+        int u = scratch.queue[front++];
+
+        for (int i = first[u]; i < first[u + 1]; i++) {
+            int e = adj[i], w = head[e];
+            if (scratch.seen[w] != stamp && scratch.residual[e] >= delta) {
+                scratch.seen[w] = stamp;
+                scratch.parent[w] = e;
+                if (isTarget(w)) return w;
+                scratch.queue[back++] = w;
+            }
+        }
+    }
+    return -1;
+}
+
+template<typename Cap>
+template<typename F>
+int FlowGraph<Cap>::levelSearch(int src, F isTarget, Scratch &scratch) const {
+    unsigned int stamp = scratch.stamp;
+    Cap delta = scratch.delta;
+    int words = (n + 63) / 64;
+    scratch.visited.assign(words, 0);
+    scratch.frontier.assign(words, 0);
+    scratch.next.assign(words, 0);
+
+    auto degree = [&](int v) { return first[v + 1] - first[v]; };
+    auto visit = [&](int w, int e) {
+        scratch.seen[w] = stamp;
+        scratch.parent[w] = e;
+    };
+
+    int front = 0, back = 0;
+    scratch.queue[back++] = src;
+    scratch.visited[src >> 6] |= 1ULL << (src & 63);
+    visit(src, -1);
+
+    long long frontierArcs = degree(src), unexplored = (long long) adj.size() - degree(src);
+    bool bottomUp = false;
+
+    while (front < back) {
+        int level = back;
+        long long nextArcs = 0;
+
+        if (level - front < PARALLEL_LEVEL) { // small level, expanded from the queue
+            bottomUp = false;
+            for (; front < level; front++) {
+                int u = scratch.queue[front];
+                for (int i = first[u]; i < first[u + 1]; i++) {
+                    int e = adj[i], w = head[e];
+                    if (scratch.residual[e] >= delta && !testBit(scratch.visited, w)) {
+                        scratch.visited[w >> 6] |= 1ULL << (w & 63);
+                        visit(w, e);
+                        if (isTarget(w)) return w;
+                        scratch.queue[back++] = w;
+                        nextArcs += degree(w);
+                    }
+                }
+            }
+            unexplored -= nextArcs;
+            frontierArcs = nextArcs;
+            continue;
+        }
+
+        TraceScope step("parallel level");
+        if (!bottomUp && frontierArcs > unexplored / ALPHA) bottomUp = true;
+        else if (bottomUp && level - front < n / BETA) bottomUp = false;
+        std::atomic<int> found(INT_MAX);
+        auto reach = [&](int w) {
+            if (!isTarget(w)) return;
+            for (int f = found.load(); w < f && !found.compare_exchange_weak(f, w); ); // smallest target, so the choice does not depend on timing
+        };
+
+        if (bottomUp) {
+            for (int i = front; i < level; i++) scratch.frontier[scratch.queue[i] >> 6] |= 1ULL << (scratch.queue[i] & 63);
+
+            parallelFor((n + LEVEL_CHUNK - 1) / LEVEL_CHUNK, [&](int chunk, int) {
+                int end = std::min(n, (chunk + 1) * LEVEL_CHUNK);
+                for (int w = chunk * LEVEL_CHUNK; w < end; w++) {
+                    if (testBit(scratch.visited, w)) continue;
+                    for (int i = first[w]; i < first[w + 1]; i++) {
+                        int e = adj[i] ^ 1; // arc into w
+                        if (scratch.residual[e] >= delta && testBit(scratch.frontier, head[adj[i]])) {
+                            scratch.next[w >> 6] |= 1ULL << (w & 63);
+                            visit(w, e);
+                            reach(w);
+                            break;
+                        }
+                    }
+                }
+            });
+
+            for (int i = front; i < level; i++) scratch.frontier[scratch.queue[i] >> 6] = 0;
+        }
+        else {
+            parallelFor((level - front + LEVEL_CHUNK - 1) / LEVEL_CHUNK, [&](int chunk, int) {
+                int end = std::min(level, front + (chunk + 1) * LEVEL_CHUNK);
+                for (int j = front + chunk * LEVEL_CHUNK; j < end; j++) {
+                    int u = scratch.queue[j];
+                    for (int i = first[u]; i < first[u + 1]; i++) {
+                        int e = adj[i], w = head[e];
+                        if (scratch.residual[e] >= delta && claimBit(scratch.visited, w)) {
+                            claimBit(scratch.next, w);
+                            visit(w, e);
+                            reach(w);
+                        }
+                    }
+                }
+            });
+        }
+
+        if (found != INT_MAX) return found;
+
+        for (int i = 0; i < words; i++) { // the next level becomes the frontier, in vertex order
+            uint64_t bits = scratch.next[i];
+            scratch.visited[i] |= bits;
+            scratch.next[i] = 0;
+            for (; bits; bits &= bits - 1) {
+                int w = i * 64 + __builtin_ctzll(bits);
+                scratch.queue[back++] = w;
+                nextArcs += degree(w);
+            }
+        }
+        front = level;
+        unexplored -= nextArcs;
+        frontierArcs = nextArcs;
+    }
+    return -1;
+}
+
+template<typename Cap>
+bool FlowGraph<Cap>::bidirectionalSearch(int src, int dest, Scratch &scratch) const {
+    TraceScope scope("bidirectional bfs");
+    unsigned int stamp = nextSearch(scratch);
+    Cap delta = scratch.delta;
+
+    int front = 0, back = 0;         // forward levels, from the start of the queue
+    int destFront = n, destBack = n; // backward levels, from the end of the queue
+    scratch.queue[back++] = src;
+    scratch.seen[src] = stamp;
+    scratch.parent[src] = -1;
+    scratch.queue[--destBack] = dest;
+    scratch.seenFromDest[dest] = stamp;
+    scratch.child[dest] = -1;
+
+    int meet = -1;
+    while (meet == -1 && front < back && destBack < destFront) {
+        if (back - front <= destFront - destBack) {
+            for (int level = back; meet == -1 && front < level; front++) {
+                int u = scratch.queue[front];
+                for (int i = first[u]; i < first[u + 1]; i++) {
+                    int e = adj[i], w = head[e];
+                    if (scratch.seen[w] == stamp || scratch.residual[e] < delta) continue;
+                    scratch.seen[w] = stamp;
+                    scratch.parent[w] = e;
+                    if (scratch.seenFromDest[w] == stamp) { meet = w; break; }
+                    scratch.queue[back++] = w;
+                }
+            }
+        }
+        else {
+            for (int level = destBack; meet == -1 && destFront > level; ) {
+                int v = scratch.queue[--destFront];
+                for (int i = first[v]; i < first[v + 1]; i++) {
+                    int e = adj[i] ^ 1, w = head[adj[i]]; // e goes from w into v
+                    if (scratch.seenFromDest[w] == stamp || scratch.residual[e] < delta) continue;
+                    scratch.seenFromDest[w] = stamp;
+                    scratch.child[w] = e;
+                    if (scratch.seen[w] == stamp) { meet = w; break; }
+                    scratch.queue[--destBack] = w;
+                }
+            }
+        }
+    }
+    if (meet == -1) return false;
+
+    for (int v = meet; v != dest; v = head[scratch.child[v]]) scratch.parent[head[scratch.child[v]]] = scratch.child[v];
+    return true;
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::push(int src, int dest, Scratch &scratch, long long limit) const {
+    TraceScope scope("update path");
+    Cap flow = (Cap) std::min<long long>(limit, std::numeric_limits<Cap>::max());
+    for (int v = dest; v != src; v = head[scratch.parent[v] ^ 1])
+        flow = std::min(flow, scratch.residual[scratch.parent[v]]);
+
+    for (int v = dest; v != src; v = head[scratch.parent[v] ^ 1]) {
+        scratch.residual[scratch.parent[v]] -= flow;
+        scratch.residual[scratch.parent[v] ^ 1] += flow;
+    }
+    scratch.augmentations++;
+    return flow;
+}
+
+template<typename Cap>
+bool FlowGraph<Cap>::findAugmentingPath(int src, int dest, Scratch &scratch, PathSearch mode) const {
+    if (src == dest) return false;
+    if (mode == BIDIRECTIONAL_SEARCH) return bidirectionalSearch(src, dest, scratch);
+    return search(src, [dest](int v) { return v == dest; }, scratch) != -1;
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::augment(int src, int dest, Scratch &scratch, PathSearch mode, FlowAlgorithm algorithm) const {
+    long long max_flow = 0, delta = 1;
+
+    if (algorithm == CAPACITY_SCALING) {
+        long long largest = 0;
+        for (int i = first[src]; i < first[src + 1]; i++) largest = std::max<long long>(largest, scratch.residual[adj[i]]);
+        while (delta * 2 <= largest) delta *= 2;
+    }
+
+    for (; delta > 0; delta /= 2) { // Edmonds-Karp is the single phase with delta 1
+        TraceScope phase("scaling phase");
+        scratch.delta = (Cap) delta;
+        while (findAugmentingPath(src, dest, scratch, mode)) max_flow += push(src, dest, scratch);
+    }
+
+    return max_flow;
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::augmentToSet(int src, const vec<bool> &targets, Scratch &scratch) const {
+    long long max_flow = 0;
+    if (targets[src]) return max_flow;
+
+    for (int t; (t = search(src, [&targets](int v) { return targets[v]; }, scratch)) != -1; )
+        max_flow += push(src, t, scratch);
+
+    return max_flow;
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::maxFlow(int src, int dest, Scratch &scratch, PathSearch mode, FlowAlgorithm algorithm) const {
+    reset(scratch);
+    return augment(src, dest, scratch, mode, algorithm);
+}
+
+template<typename Cap>
+void FlowGraph<Cap>::sourceSide(int src, Scratch &scratch, vec<bool> &side) const {
+    search(src, [](int) { return false; }, scratch);
+    side.assign(n, false);
+    for (int v = 0; v < n; v++) side[v] = scratch.seen[v] == scratch.stamp;
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::getFlow(int e, const Scratch &scratch) const {
+    return ((long long) scratch.residual[e ^ 1] - scratch.residual[e]) / 2;
+}
+
+template<typename Cap>
+long long FlowGraph<Cap>::fail(int src, int dest, long long value, const vec<int> &failedArcs, const vec<int> &failedVertices, Scratch &scratch) const {
+    TraceScope scope("repair");
+    vec<int> dirty;
+
+    auto cut = [&](int e) {
+        if (scratch.residual[e] == 0 && scratch.residual[e ^ 1] == 0) return; // already failed
+        long long f = getFlow(e, scratch);
+        int a = head[e ^ 1], b = head[e];
+        scratch.residual[e] = scratch.residual[e ^ 1] = 0;
+        if (f < 0) std::swap(a, b), f = -f;
+        if (f == 0) return;
+
+        if (a == src) value -= f;
+        else if (a != dest) scratch.excess[a] += f, dirty.push_back(a);
+        if (b == src) value += f;
+        else if (b != dest) scratch.excess[b] -= f, dirty.push_back(b);
+    };
+
+    for (int v : failedVertices)
+        if (v == src || v == dest) return 0; // before any cut, so no excess is left behind in the scratch
+    for (int v : failedVertices)
+        for (int i = first[v]; i < first[v + 1]; i++) cut(adj[i]);
+    for (int e : failedArcs) cut(e);
+
+    bool placed = true;
+
+    for (int x : dirty) { // send every excess to a deficit, or back to src, or on to dest
+        while (placed && scratch.excess[x] > 0) {
+            int t = search(x, [&](int v) { return v == src || v == dest || scratch.excess[v] < 0; }, scratch);
+            if (t == -1) { placed = false; break; }
+            long long f = push(x, t, scratch, t == src || t == dest ? scratch.excess[x] : std::min(scratch.excess[x], -scratch.excess[t]));
+            scratch.excess[x] -= f;
+            if (t == src) value -= f;
+            else if (t != dest) scratch.excess[t] += f;
+        }
+    }
+
+    for (int y : dirty) { // fill every remaining deficit from dest, or else from src
+        while (placed && scratch.excess[y] < 0) {
+            int from = dest;
+            if (search(dest, [y](int v) { return v == y; }, scratch) == -1) {
+                from = src;
+                if (search(src, [y](int v) { return v == y; }, scratch) == -1) { placed = false; break; }
+            }
+            long long f = push(from, y, scratch, -scratch.excess[y]);
+            scratch.excess[y] += f;
+            if (from == src) value += f;
+        }
+    }
+
+    if (!placed) { // cold start with the same failures
+        for (int x : dirty) scratch.excess[x] = 0;
+        reset(scratch);
+        for (int v : failedVertices)
+            for (int i = first[v]; i < first[v + 1]; i++) scratch.residual[adj[i]] = scratch.residual[adj[i] ^ 1] = 0;
+        for (int e : failedArcs) scratch.residual[e] = scratch.residual[e ^ 1] = 0;
+        return augment(src, dest, scratch);
+    }
+
+    return value + augment(src, dest, scratch);
+}
+
+template class FlowGraph<int16_t>;
+template class FlowGraph<int32_t>;
+template class FlowGraph<int64_t>;
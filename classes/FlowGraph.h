@@ -0,0 +1,553 @@
+#ifndef RAILWAYS_FLOWGRAPH_H
+#define RAILWAYS_FLOWGRAPH_H
+
+#include "StationLink.h"
+#include "Trace.h"
+#include "Parallel.h"
+#include "Scenario.h"
+
+/**
+ * @brief Path Search
+ *
+ * @details How augmenting paths between two vertices are searched for
+ */
+enum PathSearch {
+    FORWARD_SEARCH,      ///< Breadth-first from the source until the destination is reached
+    BIDIRECTIONAL_SEARCH ///< Breadth-first from both ends, one level at a time from the smaller frontier, until they meet
+};
+
+/**
+ * @brief Flow Algorithm
+ *
+ * @details Augmenting path algorithm used by FlowGraph::augment
+ */
+enum FlowAlgorithm {
+    EDMONDS_KARP,    ///< Shortest augmenting paths
+    CAPACITY_SCALING ///< Shortest paths with residual of at least delta, halving delta down to 1
+};
+
+/**
+ * @brief Flow Scratch
+ *
+ * @tparam Cap Capacity type of the graph
+ *
+ * @details Working memory of one flow computation over a FlowGraph.
+ * The graph itself is never modified by the flow kernels, so several threads can run flows on the same graph at the
+ * same time as long as each one uses its own scratch.
+ */
+template<typename Cap = int>
+struct FlowScratch {
+    /**
+     * @brief Residual capacity of every arc
+     */
+    vec<Cap> residual;
+
+    /**
+     * @brief Arc that discovered each vertex in the last search (-1 if none)
+     */
+    vec<int> parent;
+
+    /**
+     * @brief Arc that leads each vertex towards the destination in the last bidirectional search (-1 if none)
+     */
+    vec<int> child;
+
+    /**
+     * @brief Search queue (a bidirectional search fills it from both ends)
+     */
+    vec<int> queue;
+
+    /**
+     * @brief Search in which each vertex was last visited
+     */
+    vec<unsigned int> seen;
+
+    /**
+     * @brief Search in which each vertex was last reached from the destination, in bidirectional searches
+     */
+    vec<unsigned int> seenFromDest;
+
+    /**
+     * @brief Current search
+     */
+    unsigned int stamp = 0;
+
+    /**
+     * @brief Smallest residual an arc needs to be searched through (1 except during capacity scaling)
+     */
+    Cap delta = 1;
+
+    /**
+     * @brief Number of paths pushed since the last reset
+     */
+    long long augmentations = 0;
+
+    /**
+     * @brief Bitmaps of the visited vertices, the current level and the next level of a level search
+     */
+    vec<uint64_t> visited, frontier, next;
+
+    /**
+     * @brief Excess of each vertex while a flow is being repaired (negative for a deficit)
+     */
+    vec<long long> excess;
+};
+
+/**
+ * @brief Flow Graph class
+ *
+ * @details Compact, read-only snapshot of the network used by the flow kernels.
+ * Vertices are numbered 0..n-1 and arcs are stored in adjacency arrays (CSR). Every link and its reverse form the arc
+ * pair (2p, 2p + 1), so the reverse of arc e is always e ^ 1. Both arcs of a pair share the residual of the link:
+ * pushing flow through one of them gives the same amount of residual capacity back to the other.
+ * Capacities and residuals are stored as Cap, so a narrow type keeps more of the graph in cache. Residuals of a pair
+ * add up to twice the capacity of the link, which must fit in Cap (see withFlowGraph). Flow values are always
+ * returned as long long.
+ *
+ * @tparam Cap Capacity type (int16_t, int32_t or int64_t)
+ */
+template<typename Cap = int>
+class FlowGraph {
+public:
+
+    /**
+     * @brief Capacity type of this graph
+     */
+    using Capacity = Cap;
+
+    /**
+     * @brief Scratch type of this graph
+     */
+    using Scratch = FlowScratch<Cap>;
+
+private:
+
+    /**
+     * @brief Number of vertices
+     */
+    int n = 0;
+
+    /**
+     * @brief Super source vertex (-1 if the graph has none)
+     */
+    int superSource = -1;
+
+    /**
+     * @brief First position in adj of the arcs of each vertex (size n + 1)
+     */
+    vec<int> first;
+
+    /**
+     * @brief Arcs leaving each vertex, grouped by vertex
+     */
+    vec<int> adj;
+
+    /**
+     * @brief Destination vertex of each arc
+     */
+    vec<int> head;
+
+    /**
+     * @brief Capacity of each arc
+     *
+     * @details 0 if the arc is disabled. An arc is enabled when its link and both of its stations were enabled when
+     * the snapshot was taken
+     */
+    vec<Cap> capacity;
+
+    /**
+     * @brief Arc from the super source to each vertex (-1 if none)
+     */
+    vec<int> sourceArc;
+
+    /**
+     * @brief Station of each vertex (nullptr for the super source)
+     */
+    vec<ptr<Station>> vertices;
+
+    /**
+     * @brief Link of each arc (nullptr for super source arcs)
+     */
+    vec<ptr<Link>> arcs;
+
+    /**
+     * @brief Vertex of each station id
+     */
+    std::unordered_map<int, int> index;
+
+    /**
+     * @brief Arc of each link
+     */
+    std::unordered_map<const Link*, int> arcIndex;
+
+    /**
+     * @brief Search
+     *
+     * @param src Source vertex
+     * @param isTarget Predicate telling whether a vertex ends the search
+     * @param scratch Scratch holding the residual graph
+     *
+     * @return First target vertex reached, or -1 if none is reachable
+     *
+     * @details Breadth-first search over the residual graph. The path is left in scratch.parent.
+     */
+    template<typename F>
+    int search(int src, F isTarget, Scratch &scratch) const;
+
+    /**
+     * @brief Level Search
+     *
+     * @param src Source vertex
+     * @param isTarget Predicate telling whether a vertex ends the search (called from several threads)
+     * @param scratch Scratch holding the residual graph, with the stamp of this search already set
+     *
+     * @return A target vertex of the first level that has one, or -1 if none is reachable
+     *
+     * @details Breadth-first search for large graphs, one level at a time. Small levels are expanded from the queue
+     * as usual. Large levels are expanded in parallel, with the visited vertices and the next level kept as bitmaps:
+     * top-down, from every frontier vertex along its residual arcs, or bottom-up, from every unvisited vertex looking
+     * for a residual arc from the frontier, whichever scans fewer arcs. Paths are still shortest, but the one picked
+     * among paths of the same length may differ between runs. The path is left in scratch.parent, as in search.
+     */
+    template<typename F>
+    int levelSearch(int src, F isTarget, Scratch &scratch) const;
+
+    /**
+     * @brief Bidirectional Search
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param scratch Scratch holding the residual graph
+     *
+     * @return true if a path with residual capacity exists
+     *
+     * @details Breadth-first search from src along residual arcs and from dest against them, expanding a whole level of
+     * the side with the smaller frontier each time. The first vertex reached by both sides closes a shortest path,
+     * which is left in scratch.parent as in search. On long corridors each side only explores around its own end.
+     */
+    bool bidirectionalSearch(int src, int dest, Scratch &scratch) const;
+
+    /**
+     * @brief Push
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param scratch Scratch holding the residual graph and the path
+     * @param limit Maximum flow to push
+     *
+     * @return Flow pushed
+     *
+     * @details Pushes the bottleneck of the path in scratch.parent from src to dest, up to limit.
+     */
+    long long push(int src, int dest, Scratch &scratch, long long limit = LLONG_MAX) const;
+
+public:
+
+    /**
+     * @brief Flow Graph Constructor
+     *
+     * @param stations Stations of the network
+     * @param links Links of the network
+     * @param withSuperSource Whether to add a super source linked to every source station
+     *
+     * @details Takes a snapshot of the stations and links, including their enabled status.
+     * Source stations are the ones with a single link, as in Network::maxTrains. The arc from the super source to a
+     * source station gets half the largest value of Cap, so it never limits the flow: the link of the station does, with
+     * whatever capacity the network or a scenario gives it. Half, so the arc and its reverse add up within Cap.
+     * This function has Complexity O(V + E) where V is the number of vertices and E is the number of edges.
+     */
+    FlowGraph(const vec<ptr<Station>> &stations, const vec<ptr<Link>> &links, bool withSuperSource = false);
+
+    /**
+     * @brief Get Size
+     *
+     * @return Number of vertices, including the super source
+     */
+    int size() const;
+
+    /**
+     * @brief Get Arc Count
+     *
+     * @return Number of arcs
+     */
+    int arcCount() const;
+
+    /**
+     * @brief Get Vertex
+     *
+     * @param station Station
+     *
+     * @return Vertex of the station, or -1 if the station is not in the graph
+     */
+    int vertex(const ptr<Station> &station) const;
+
+    /**
+     * @brief Get Station
+     *
+     * @param v Vertex
+     *
+     * @return Station of the vertex (nullptr for the super source)
+     */
+    ptr<Station> station(int v) const;
+
+    /**
+     * @brief Get Link
+     *
+     * @param e Arc
+     *
+     * @return Link of the arc (nullptr for super source arcs)
+     */
+    ptr<Link> link(int e) const;
+
+    /**
+     * @brief Get Arc
+     *
+     * @param link Link
+     *
+     * @return Arc of the link, or -1 if the link is not in the graph
+     */
+    int arc(const ptr<Link> &link) const;
+
+    /**
+     * @brief Get Head
+     *
+     * @param e Arc
+     *
+     * @return Destination vertex of the arc
+     */
+    int getHead(int e) const;
+
+    /**
+     * @brief Get Tail
+     *
+     * @param e Arc
+     *
+     * @return Source vertex of the arc
+     */
+    int getTail(int e) const;
+
+    /**
+     * @brief Get Capacity
+     *
+     * @param e Arc
+     *
+     * @return Capacity of the arc (0 if disabled)
+     */
+    long long getCapacity(int e) const;
+
+    /**
+     * @brief Get Super Source
+     *
+     * @return Super source vertex, or -1 if the graph has none
+     */
+    int getSuperSource() const;
+
+    /**
+     * @brief Get Source Arc
+     *
+     * @param v Vertex
+     *
+     * @return Arc from the super source to v, or -1 if v is not a source
+     */
+    int getSourceArc(int v) const;
+
+    /**
+     * @brief Get Sink Arcs
+     *
+     * @param sink Vertex the super source sends flow to
+     *
+     * @return Arcs to remove so the sink is not one of its own sources: its source arc, if it has one
+     */
+    vec<int> getSinkArcs(int sink) const;
+
+    /**
+     * @brief Remove Arcs
+     *
+     * @param arcs Arcs to remove, with their reverse
+     * @param scratch Scratch holding the residual graph
+     *
+     * @details This function has Complexity O(A) where A is the number of arcs removed.
+     */
+    void removeArcs(const vec<int> &arcs, Scratch &scratch) const;
+
+    /**
+     * @brief Reset
+     *
+     * @param scratch Scratch to reset
+     *
+     * @details Sizes the scratch for this graph and sets the residual of every arc to its capacity (0 if disabled).
+     * This function has Complexity O(V + E).
+     */
+    void reset(Scratch &scratch) const;
+
+    /**
+     * @brief Reset
+     *
+     * @param scratch Scratch to reset
+     * @param scenario Scenario to apply
+     *
+     * @details Same as reset, then applies the capacity changes of the scenario and removes its stations and links
+     * (the arcs of a station out of service, including its super source arc, get no residual).
+     * Super source arcs never limit the flow, so a change to the link of a source station counts as it would on the
+     * network itself. Changes of the base scenarios are applied first. This function has Complexity O(V + E + C) where C is the number
+     * of changes.
+     *
+     * @warning Capacities set by the scenario must fit the capacity type (see withFlowGraph)
+     */
+    void reset(Scratch &scratch, const Scenario &scenario) const;
+
+    /**
+     * @brief Find Augmenting Path
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param scratch Scratch holding the residual graph
+     * @param mode How to search (see PathSearch)
+     *
+     * @return true if a path with residual capacity exists
+     *
+     * @details Breadth-first search over the residual graph. The path is left in scratch.parent. On graphs with many
+     * vertices, large levels of the search are expanded in parallel (see levelSearch), unless the flow itself runs
+     * inside a parallel loop or there is a single hardware thread.
+     * This function has Complexity O(V + E).
+     */
+    bool findAugmentingPath(int src, int dest, Scratch &scratch, PathSearch mode = FORWARD_SEARCH) const;
+
+    /**
+     * @brief Augment
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param scratch Scratch holding the residual graph
+     * @param mode How to search for augmenting paths (see PathSearch)
+     * @param algorithm Augmenting path algorithm (see FlowAlgorithm)
+     *
+     * @return Flow added from src to dest
+     *
+     * @details Runs Edmonds-Karp, or capacity scaling, starting from the current residual graph in the scratch, so it
+     * can continue from a previous flow. Every path pushed is counted in scratch.augmentations.
+     * This function has Complexity O(VE^2) for Edmonds-Karp and O(E^2 log(U)) for capacity scaling, where U is the
+     * largest capacity out of src.
+     */
+    long long augment(int src, int dest, Scratch &scratch, PathSearch mode = FORWARD_SEARCH, FlowAlgorithm algorithm = EDMONDS_KARP) const;
+
+    /**
+     * @brief Augment To Set
+     *
+     * @param src Source vertex
+     * @param targets Target status of each vertex
+     * @param scratch Scratch holding the residual graph
+     *
+     * @return Flow added from src to the targets
+     *
+     * @details Same as augment, but every target vertex acts as the destination, as if they were all linked to a super
+     * sink with infinite capacity. This function has Complexity O(VE^2).
+     */
+    long long augmentToSet(int src, const vec<bool> &targets, Scratch &scratch) const;
+
+    /**
+     * @brief Max Flow
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param scratch Scratch to use
+     * @param mode How to search for augmenting paths (see PathSearch)
+     * @param algorithm Augmenting path algorithm (see FlowAlgorithm)
+     *
+     * @return Max flow between src and dest
+     *
+     * @details Resets the scratch and runs augment. This function has the Complexity of augment.
+     */
+    long long maxFlow(int src, int dest, Scratch &scratch, PathSearch mode = FORWARD_SEARCH, FlowAlgorithm algorithm = EDMONDS_KARP) const;
+
+    /**
+     * @brief Source Side
+     *
+     * @param src Source vertex
+     * @param scratch Scratch holding a max flow from src
+     * @param side Set to whether each vertex is reachable from src in the residual graph
+     *
+     * @details After a max flow, the vertices reachable from src are the source side of a minimum cut.
+     * This function has Complexity O(V + E).
+     */
+    void sourceSide(int src, Scratch &scratch, vec<bool> &side) const;
+
+    /**
+     * @brief Get Flow
+     *
+     * @param e Arc
+     * @param scratch Scratch holding a flow
+     *
+     * @return Net flow along the arc (negative if the flow goes through the reverse arc)
+     *
+     * @details Half the difference between the residuals of the arc pair, so it does not depend on the capacity the
+     * scratch was reset with (0 for a removed pair).
+     */
+    long long getFlow(int e, const Scratch &scratch) const;
+
+    /**
+     * @brief Fail
+     *
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param value Value of the max flow in the scratch
+     * @param failedArcs Arcs whose links fail (both directions)
+     * @param failedVertices Vertices that fail, with all of their arcs
+     * @param scratch Scratch holding a max flow from src to dest
+     *
+     * @return Max flow from src to dest after the failures
+     *
+     * @details Warm start for failure scenarios: instead of solving again from scratch, the flow that went through the
+     * failed arcs is removed, the excess it leaves behind is rerouted through the residual graph (or sent back to src
+     * and dest), and the result is augmented again. If the excess cannot be placed, the flow is solved from a reset
+     * scratch. The scratch is left with the new max flow.
+     * This function has Complexity O(F * (V + E)) where F is the flow going through the failed arcs, and O(VE^2) in the
+     * worst case.
+     */
+    long long fail(int src, int dest, long long value, const vec<int> &failedArcs, const vec<int> &failedVertices, Scratch &scratch) const;
+};
+
+/**
+ * @brief Residual Bound
+ *
+ * @param links Links of the network
+ *
+ * @return Largest residual any link arc of the FlowGraph of these links can reach
+ *
+ * @details Super source arcs are left out, as they take their capacity from the type chosen.
+ * This function has Complexity O(E).
+ */
+long long residualBound(const vec<ptr<Link>> &links);
+
+/**
+ * @brief With Flow Graph
+ *
+ * @param stations Stations of the network
+ * @param links Links of the network
+ * @param withSuperSource Whether to add a super source linked to every source station
+ * @param fn Called with the graph
+ * @param maxCapacity Largest capacity a scenario will set on the graph (0 if none)
+ *
+ * @details Takes the snapshot with the narrowest capacity type that holds every residual: 16 bits for the usual
+ * networks, 32 bits, or 64 bits for very large capacities. fn must accept a FlowGraph of any of them (a generic lambda).
+ * This function has Complexity O(V + E), plus the complexity of fn.
+ */
+template<typename F>
+void withFlowGraph(const vec<ptr<Station>> &stations, const vec<ptr<Link>> &links, bool withSuperSource, F fn, long long maxCapacity = 0) {
+    long long bound = std::max(residualBound(links), 2 * maxCapacity);
+    if (bound <= std::numeric_limits<int16_t>::max()) {
+        FlowGraph<int16_t> graph(stations, links, withSuperSource);
+        fn(graph);
+    }
+    else if (bound <= std::numeric_limits<int32_t>::max()) {
+        FlowGraph<int32_t> graph(stations, links, withSuperSource);
+        fn(graph);
+    }
+    else {
+        FlowGraph<int64_t> graph(stations, links, withSuperSource);
+        fn(graph);
+    }
+}
+
+
+#endif //RAILWAYS_FLOWGRAPH_H
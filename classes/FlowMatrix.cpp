@@ -0,0 +1,144 @@
+#include "FlowMatrix.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[4] = {'R', 'W', 'F', 'M'};
+    const uint32_t FORMAT = 1;
+}
+
+uint64_t FlowMatrix::fileChecksum(const vec<std::string> &paths) {
+    uint64_t hash = 14695981039346656037ULL;
+    char buffer[1 << 16];
+    for (auto &path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        while (file) {
+            file.read(buffer, sizeof(buffer));
+            for (std::streamsize i = 0; i < file.gcount(); i++) hash = (hash ^ (unsigned char) buffer[i]) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xFF) * 1099511628211ULL; // file separator
+    }
+    return hash;
+}
+
+void FlowMatrix::build(Network &network, uint64_t _checksum) {
+    TraceScope scope("build flow matrix");
+    vec<ptr<Station>> order;
+    vec<int> matrix;
+    network.allPairsMaxFlow(order, matrix);
+
+    unmap();
+    ids.clear();
+    rows.clear();
+    for (auto &s : order) {
+        rows[network.getInputId(s->getId())] = (int) ids.size();
+        ids.push_back(network.getInputId(s->getId()));
+    }
+    flows.assign(matrix.begin(), matrix.end());
+    idRows = ids.data();
+    flowRows = flows.data();
+    n = ids.size();
+    checksum = _checksum;
+}
+
+FlowMatrix::~FlowMatrix() {
+    unmap();
+}
+
+void FlowMatrix::unmap() {
+#ifndef _WIN32
+    if (mapping) munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+}
+
+bool FlowMatrix::load(const std::string &path, uint64_t _checksum) {
+    TraceScope scope("load flow matrix");
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info{};
+    void *file = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(Header))
+        file = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (file == MAP_FAILED) return false;
+
+    const Header &header = *(const Header*) file;
+    size_t size = (size_t) info.st_size, count = header.n;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format != FORMAT || header.checksum != _checksum
+        || size < sizeof(Header) + (count + count * count) * sizeof(int32_t)) {
+        munmap(file, size);
+        return false;
+    }
+
+    unmap();
+    ids.clear();
+    flows.clear();
+    mapping = file;
+    mappingSize = size;
+    idRows = (const int32_t*) ((const char*) file + sizeof(Header));
+    flowRows = idRows + count;
+    n = count;
+#else
+    std::ifstream file(path, std::ios::binary); // no mmap, read the file instead
+    Header header{};
+    if (!file.read((char*) &header, sizeof(header))) return false;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format != FORMAT || header.checksum != _checksum) return false;
+
+    size_t count = header.n;
+    vec<int32_t> fileIds(count), fileFlows(count * count);
+    if (!file.read((char*) fileIds.data(), (std::streamsize) (count * sizeof(int32_t)))) return false;
+    if (!file.read((char*) fileFlows.data(), (std::streamsize) (count * count * sizeof(int32_t)))) return false;
+    ids.swap(fileIds);
+    flows.swap(fileFlows);
+    n = count;
+    idRows = ids.data();
+    flowRows = flows.data();
+#endif
+
+    rows.clear();
+    for (int i = 0; i < (int) n; i++) rows[idRows[i]] = i;
+    checksum = _checksum;
+    return true;
+}
+
+bool FlowMatrix::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format = FORMAT;
+    header.checksum = checksum;
+    header.n = (uint32_t) n;
+    file.write((const char*) &header, sizeof(header));
+    file.write((const char*) idRows, (std::streamsize) (n * sizeof(int32_t)));
+    file.write((const char*) flowRows, (std::streamsize) (n * n * sizeof(int32_t)));
+    return (bool) file;
+}
+
+int FlowMatrix::get(int id1, int id2) const {
+    auto a = rows.find(id1), b = rows.find(id2);
+    if (a == rows.end() || b == rows.end()) return -1;
+    return flowRows[(size_t) a->second * n + b->second];
+}
+
+int FlowMatrix::maxPairs(vec<std::pair<int, int>> &pairs) const {
+    int count = (int) n, best = 0;
+    pairs.clear();
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            int flow = flowRows[(size_t) i * count + j];
+            if (flow > best) best = flow, pairs.clear();
+            if (flow == best) pairs.emplace_back(idRows[i], idRows[j]);
+        }
+    }
+    return best;
+}
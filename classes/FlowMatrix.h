@@ -0,0 +1,162 @@
+#ifndef RAILWAYS_FLOWMATRIX_H
+#define RAILWAYS_FLOWMATRIX_H
+
+#include "Network.h"
+
+/**
+ * @brief Flow Matrix class
+ *
+ * @details Max flow between every pair of stations, precomputed once and kept in a file next to the dataset.
+ * Rows and columns are indexed by the input id of the stations (Network::getInputId), so the file stays valid whatever
+ * order the stations are numbered in.
+ *
+ * The file is a fixed layout of native 32 and 64-bit integers that can be memory-mapped as is:
+ * a 24-byte header (magic "RWFM", format version, checksum of the source CSV files, number of stations n, padding),
+ * the n input ids of the rows, and the n * n max flows, row by row.
+ * A file whose header does not match (other format, other CSV contents, truncated) is treated as stale.
+ * A loaded file is memory-mapped read-only and answered from in place; a built matrix is kept in memory.
+ */
+class FlowMatrix {
+private:
+
+    /**
+     * @brief File header
+     */
+    struct Header {
+        char magic[4];
+        uint32_t format;
+        uint64_t checksum;
+        uint32_t n;
+        uint32_t padding;
+    };
+
+    /**
+     * @brief Input id of each row, when the matrix was built rather than mapped
+     */
+    vec<int32_t> ids;
+
+    /**
+     * @brief Max flow of every pair, row by row, when the matrix was built rather than mapped
+     */
+    vec<int32_t> flows;
+
+    /**
+     * @brief Input id of each row, in ids or in the mapped file
+     */
+    const int32_t *idRows = nullptr;
+
+    /**
+     * @brief Max flows, in flows or in the mapped file
+     */
+    const int32_t *flowRows = nullptr;
+
+    /**
+     * @brief Number of stations
+     */
+    size_t n = 0;
+
+    /**
+     * @brief Mapped file, or nullptr
+     */
+    void *mapping = nullptr;
+
+    /**
+     * @brief Size of the mapped file
+     */
+    size_t mappingSize = 0;
+
+    /**
+     * @brief Row of each input id
+     */
+    std::unordered_map<int, int> rows;
+
+    /**
+     * @brief Checksum of the CSV files the matrix was computed from
+     */
+    uint64_t checksum = 0;
+
+    /**
+     * @brief Unmap
+     *
+     * @details Releases the mapped file, if any.
+     */
+    void unmap();
+
+public:
+
+    FlowMatrix() = default;
+    FlowMatrix(const FlowMatrix&) = delete;
+    FlowMatrix& operator=(const FlowMatrix&) = delete;
+    ~FlowMatrix();
+
+    /**
+     * @brief File Checksum
+     *
+     * @param paths Files to hash
+     *
+     * @return 64-bit FNV-1a hash of the contents of the files, in order (a missing file hashes as empty)
+     *
+     * @details This function has Complexity O(N) where N is the total size of the files.
+     */
+    static uint64_t fileChecksum(const vec<std::string> &paths);
+
+    /**
+     * @brief Build
+     *
+     * @param network Network to compute the max flows of
+     * @param checksum Checksum of the CSV files the network was read from
+     *
+     * @details This function has the Complexity of Network::allPairsMaxFlow.
+     */
+    void build(Network &network, uint64_t checksum);
+
+    /**
+     * @brief Load
+     *
+     * @param path File to map
+     * @param checksum Checksum of the current CSV files
+     *
+     * @return false if the file is missing, of another format, truncated, or computed from other CSV files
+     *
+     * @details The file is memory-mapped, so only the pages that are queried are read.
+     * This function has Complexity O(V) (the row index of the input ids).
+     */
+    bool load(const std::string &path, uint64_t checksum);
+
+    /**
+     * @brief Save
+     *
+     * @param path File to write
+     *
+     * @return true if the file was written
+     *
+     * @details This function has Complexity O(V^2).
+     */
+    bool save(const std::string &path) const;
+
+    /**
+     * @brief Get
+     *
+     * @param id1 Input id of a station
+     * @param id2 Input id of another station
+     *
+     * @return Max flow between the stations, or -1 if one of them is not in the matrix
+     *
+     * @details This function has Complexity O(1).
+     */
+    int get(int id1, int id2) const;
+
+    /**
+     * @brief Max Pairs
+     *
+     * @param pairs Filled with the input ids of every pair of stations with the largest max flow
+     *
+     * @return Largest max flow between two stations
+     *
+     * @details This function has Complexity O(V^2).
+     */
+    int maxPairs(vec<std::pair<int, int>> &pairs) const;
+};
+
+
+#endif //RAILWAYS_FLOWMATRIX_H
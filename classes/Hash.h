@@ -0,0 +1,39 @@
+#ifndef RAILWAYS_HASH_H
+#define RAILWAYS_HASH_H
+
+#include <bits/stdc++.h>
+
+/**
+ * @brief Mix
+ *
+ * @param x Value to hash
+ *
+ * @return Hash of x (splitmix64)
+ *
+ * @details Spreads every bit of x over the whole result, so hashes of parts of a state can be added together, in any
+ * order, into a hash of the whole state. Used by the query keys of the result cache and by the scenario hashes that
+ * are added to them, which must agree.
+ */
+inline unsigned long long mix(unsigned long long x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Sample Seed
+ *
+ * @param seed Seed of the run
+ * @param i Index of the sample
+ *
+ * @return Seed of the random generator of the i-th sample
+ *
+ * @details Each sample seeds its own generator, so a run draws the same numbers whatever worker takes each sample.
+ */
+inline unsigned long long sampleSeed(unsigned long long seed, long long i) {
+    return seed + 0x9E3779B97F4A7C15ULL * (i + 1);
+}
+
+
+#endif //RAILWAYS_HASH_H
@@ -1,4 +1,15 @@
 #include "Network.h"
+#include "Hash.h"
+
+namespace {
+    /**
+     * @brief Kinds of sweeps that can be checkpointed
+     */
+    enum Sweep : uint64_t {
+        MAX_FLOW_NETWORK_SWEEP = 1,
+        WORST_LINK_PAIRS_SWEEP = 2
+    };
+}
 
 Network::Network() {
     this->stations = vec<ptr<Station>>();
@@ -10,6 +21,8 @@ bool Network::addStation(const ptr<Station>& station) {
         if (s->getId() == station->getId()) return false;
 
     stations.push_back(station);
+    station->track(state);
+    version++;
     return true;
 }
 
@@ -20,6 +33,8 @@ void Network::addLink(const ptr<Station>& st1, const ptr<Station>& st2, int capa
         link->setReverse(rev); rev->setReverse(link);
         links.push_back(link); links.push_back(rev);
         st1->addLink(link); st2->addLink(rev);
+        link->track(state); rev->track(state);
+        version++;
     }
 }
 
@@ -32,6 +47,36 @@ ptr<Station> Network::getStation(int id) {
     return nullptr;
 }
 
+unsigned long long Network::getVersion() const {
+    return version;
+}
+
+ResultCache &Network::getResultCache() {
+    return cache;
+}
+
+QueryKey Network::queryKey(QueryKind kind, const ptr<Station> &src, const ptr<Station> &dest) {
+    return {kind, src ? src->getId() : -1, dest->getId(), version, *state};
+}
+
+unsigned long long Network::fingerprint() const {
+    vec<uint64_t> values;
+    for (auto &s : stations) values.push_back((uint64_t) s->getId() << 1 | s->isEnabled());
+    std::sort(values.begin(), values.end()); // some analyses reorder the stations
+    for (auto &l : links) {
+        values.push_back((uint64_t) l->getSrc()->getId() << 32 | (uint32_t) l->getDest()->getId());
+        values.push_back((uint64_t) l->getCapacity() << 8 | l->getService() << 1 | l->isEnabled());
+    }
+
+    uint64_t hash = Checkpoint::key({stations.size(), links.size()});
+    for (auto v : values) hash = Checkpoint::key({hash, v});
+    return hash;
+}
+
+int Network::getInputId(int id) {
+    return inputIds.empty() ? id : inputIds[id];
+}
+
 ptr<Station> Network::getStation(const std::string& name) {
     for (auto &s : stations) {
         if (s->getName() == name) {
@@ -55,103 +100,53 @@ bool Network::linkExists(const ptr<Station> &st1, const ptr<Station> &st2) {
 }
 
 unsigned int Network::maxFlow(const ptr<Station> &src, const ptr<Station> &dest) {
-    int max_flow = 0;
-
-    for (auto &l : links) l->setFlow(0);
+    TraceScope scope("max flow");
+    auto key = queryKey(MAX_FLOW_QUERY, src, dest);
+    unsigned int max_flow = 0;
+    if (cache.get(key, max_flow)) return max_flow;
 
-    while (getAugmentingPath(src, dest)) {
-        int flow = getBottleneck(src, dest);
-        max_flow += flow;
-        updatePath(src, dest, flow, nullptr);
-    }
+    long long augmentations;
+    max_flow = maxFlow(src, dest, EDMONDS_KARP, augmentations); // same kernel as allPairsMaxFlow, so the flow matrix agrees
 
+    cache.put(key, max_flow);
     return max_flow;
 }
 
-bool Network::getAugmentingPath(const ptr<Station> &src, const ptr<Station> &dest) {
-    for (auto &s : stations) s->setVisited(false), s->setPath(nullptr);
-
-    std::queue<ptr<Station>> q;
-    q.push(src);
-    src->setVisited(true);
-
-    while (!q.empty() && !dest->isVisited()) {
-        auto s = q.front(); q.pop();
-
-        if (!s->isEnabled()) continue;
-
-        for (auto &l : s->getLinks()) {
-            if (!l->isEnabled()) continue;
-            auto w = l->getDest();
-            if (!w->isVisited() && l->getFlow() < l->getCapacity()) {
-                w->setVisited(true);
-                w->setPath(l);
-                q.push(w);
-            }
-        }
-
-        for (auto &_l : s->getLinks()) {
-            auto l = _l->getReverse();
-            if (!l->isEnabled()) continue;
-            auto w = l->getDest();
-            if (!w->isVisited() && l->getFlow() > 0) {
-                w->setVisited(true);
-                w->setPath(l);
-                q.push(w);
-            }
-        }
-    }
-    return dest->isVisited();
-}
-
-int Network::getBottleneck(const ptr<Station> &src, const ptr<Station> &dest) {
-    int bottleneck = INT_MAX;
-    auto s = dest;
-
-    while (s != src) {
-        auto l = s->getPath();
-        if (s == l->getDest()) {
-            bottleneck = std::min(bottleneck, l->getCapacity() - l->getFlow());
-            s = l->getSrc();
-        }
-        else {
-            bottleneck = std::min(bottleneck, l->getFlow());
-            s = l->getDest();
-        }
-    }
-
-    return bottleneck;
-}
-
-void Network::updatePath(const ptr<Station> &source, const ptr<Station> &dest, int flow, unsigned int *cost) {
-    auto s = dest;
+unsigned int Network::getMaxFlowNetwork(vec<std::pair<ptr<Station>, ptr<Station>>>& pairs, Progress *progress, Checkpoint *checkpoint) {
+    TraceScope scope("max flow network");
+    unsigned int max_flow = 0;
+    uint64_t key = checkpoint ? Checkpoint::key({fingerprint(), MAX_FLOW_NETWORK_SWEEP}) : 0; // before the sort, as the order of the pairs depends on it
+    std::sort(stations.begin(), stations.end(), [](ptr<Station>& s1, ptr<Station>& s2) {
+        if (s1->maxPossibleFlow() != s2->maxPossibleFlow()) return s1->maxPossibleFlow() > s2->maxPossibleFlow();
+        return s1->getId() < s2->getId(); // same order on every run, so a checkpoint can resume it
+    });
+    long long n = (long long) stations.size(), done = 0, total = n * (n - 1) / 2;
 
-    while (s != source) {
-        auto l = s->getPath();
-        if (s == l->getDest()) {
-            l->setFlow(l->getFlow() + flow);
-            s = l->getSrc();
-        }
-        else {
-            l->setFlow(l->getFlow() - flow);
-            s = l->getDest();
-        }
-        if (cost) {
-            if (l->getService() == STANDARD) *cost += STANDARD_COST * flow;
-            else *cost += PENDULAR_COST * flow;
-        }
+    int first = 0, next = -1; // pair to start from
+    vec<long long> state;     // {i, j, pairs done, max flow, then the ids of the best pairs}
+    if (checkpoint && checkpoint->load(key, state) && state.size() >= 4) {
+        first = (int) state[0]; next = (int) state[1]; done = state[2]; max_flow = (unsigned int) state[3];
+        for (size_t p = 4; p + 1 < state.size(); p += 2) pairs.emplace_back(getStation((int) state[p]), getStation((int) state[p + 1]));
     }
-}
+    auto save = [&](int i, int j) {
+        state = {i, j, done, max_flow};
+        for (auto &[s1, s2] : pairs) state.push_back(s1->getId()), state.push_back(s2->getId());
+        checkpoint->save(key, state);
+    };
 
-unsigned int Network::getMaxFlowNetwork(vec<std::pair<ptr<Station>, ptr<Station>>>& pairs) {
-    unsigned int max_flow = 0;
-    std::sort(stations.begin(), stations.end(), [](ptr<Station>& s1, ptr<Station>& s2) { return s1->maxPossibleFlow() > s2->maxPossibleFlow(); });
-
-    for (int i = 0; i < (int) stations.size() - 1; i++) {
+    for (int i = first; i < (int) stations.size() - 1; i++) {
         ptr<Station> s1 = stations[i];
-        if (s1->maxPossibleFlow() < max_flow) continue;
+        if (s1->maxPossibleFlow() < max_flow) { done += n - 1 - i; continue; }
 
-        for (int j = i + 1; j < (int) stations.size(); j++) {
+        for (int j = i == first && next != -1 ? next : i + 1; j < (int) stations.size(); j++, done++) {
+            if (checkpoint && checkpoint->due()) save(i, j);
+            if (progress) {
+                if (progress->isCancelled()) {
+                    if (checkpoint) save(i, j);
+                    return max_flow;
+                }
+                progress->report(done, total, max_flow);
+            }
             ptr<Station> s2 = stations[j];
             if (s2->maxPossibleFlow() < max_flow) continue;
 
@@ -166,66 +161,257 @@ unsigned int Network::getMaxFlowNetwork(vec<std::pair<ptr<Station>, ptr<Station>
         }
     }
 
+    if (checkpoint) checkpoint->remove();
+    if (progress) progress->report(total, total, max_flow);
     return max_flow;
 }
 
 unsigned int Network::maxTrains(const ptr<Station> &sink) {
-    vec<ptr<Station>> sources;
-    for (auto &s : stations) {
-        if (s->getId() == sink->getId()) continue;
-        if (s->getLinks().size() == 1) sources.push_back(s);
-    }
+    TraceScope scope("max trains");
+    auto key = queryKey(MAX_TRAINS_QUERY, nullptr, sink);
+    unsigned int max_trains;
+    if (cache.get(key, max_trains)) return max_trains;
 
-    ptr<Station> super_source;
-    createSuperSource(super_source, sources);
-    unsigned int max_trains = maxFlow(super_source, sink);
-    removeSuperSource(super_source);
+    long long augmentations;
+    max_trains = maxTrains(sink, EDMONDS_KARP, augmentations); // the super source lives in the snapshot, the network is untouched
 
+    cache.put(key, max_trains);
     return max_trains;
 }
 
-void Network::createSuperSource(ptr<Station> &ss, const vec<ptr<Station>> &sources) {
-    ss = make<Station>(-1, "N/A", "N/A", "N/A", "N/A");
-    stations.push_back(ss);
+long long Network::maxCost(const ptr<Station> &src, const ptr<Station> &dest) {
+    TraceScope scope("max cost");
+    auto key = queryKey(MAX_COST_QUERY, src, dest);
+    long long max_cost = 0;
+    if (cache.get(key, max_cost)) return max_cost;
+
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        max_cost = minCostMaxFlow(graph, graph.vertex(src), graph.vertex(dest));
+    });
 
-    for (auto &s : sources) addLink(ss, s, 10000000, STANDARD);
+    cache.put(key, max_cost);
+    return max_cost;
 }
 
-void Network::removeSuperSource(ptr<Station> &superSource) {
-    for (auto &l : superSource->getLinks()) {
-        auto s = l->getDest();
-        s->removeLink(l->getReverse());
-        s->removeLink(l);
-        links.erase(std::find(links.begin(), links.end(), l));
+template<typename Graph>
+long long Network::minCostMaxFlow(const Graph &graph, int src, int dest) {
+    using Cap = std::conditional_t<(sizeof(typename Graph::Capacity) > sizeof(int)), long long, int>;
+    CostFlowGraph<Cap> costs(graph.size());
+    vec<std::pair<ptr<Link>, int>> arcs; // {link, its arc}
+
+    for (int e = 0; e < graph.arcCount(); e++) {
+        graph.link(e)->setFlow(0);
+        if (graph.getCapacity(e) == 0) continue;
+        arcs.emplace_back(graph.link(e), costs.addArc(graph.getTail(e), graph.getHead(e), graph.getCapacity(e), graph.link(e)->getCost()));
     }
-    stations.erase(std::find(stations.begin(), stations.end(), superSource));
-}
 
-unsigned int Network::maxCost(const ptr<Station> &src, const ptr<Station> &dest) {
-    unsigned int max_cost = 0;
+    Cap flow;
+    long long cost = costs.costScaling(src, dest, flow);
+    for (auto &[l, a] : arcs) l->setFlow((int) costs.getFlow(a));
+    return cost;
+}
 
+unsigned int Network::trainRoutes(const ptr<Station> &src, const ptr<Station> &dest, bool minCost, const std::function<void(const vec<ptr<Link>> &, int)> &route) {
+    TraceScope scope("train routes");
     for (auto &l : links) l->setFlow(0);
 
-    while (getAugmentingPathWithCosts(src, dest)) { // path with all service links
-        int flow = getBottleneck(src, dest);
-        updatePath(src, dest, flow, &max_cost);
+    if (minCost) withFlowGraph(stations, links, false, [&](auto &graph) { minCostMaxFlow(graph, graph.vertex(src), graph.vertex(dest)); });
+    else withFlowGraph(stations, links, false, [&](auto &graph) {
+        typename std::decay_t<decltype(graph)>::Scratch sc;
+        graph.maxFlow(graph.vertex(src), graph.vertex(dest), sc, BIDIRECTIONAL_SEARCH, EDMONDS_KARP);
+        for (int e = 0; e < graph.arcCount(); e++) graph.link(e)->setFlow((int) std::max(0LL, graph.getFlow(e, sc)));
+    });
+
+    return decomposeFlow(src, dest, route);
+}
+
+unsigned int Network::budgetTrains(const ptr<Station> &src, const ptr<Station> &dest, long long budget, vec<std::pair<long long, long long>> &curve) {
+    TraceScope scope("budget trains");
+    curve.assign(1, {0, 0});
+    if (src == dest) return 0;
+
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        using Cap = std::conditional_t<(sizeof(typename std::decay_t<decltype(graph)>::Capacity) > sizeof(int)), long long, int>;
+        CostFlowGraph<Cap> costs(graph.size());
+        for (int e = 0; e < graph.arcCount(); e++) {
+            if (graph.getCapacity(e) == 0) continue;
+            costs.addArc(graph.getTail(e), graph.getHead(e), graph.getCapacity(e), graph.link(e)->getCost());
+        }
+
+        long long slope = -1; // cost per train of the last segment
+        costs.successiveShortestPaths(graph.vertex(src), graph.vertex(dest), [&](Cap bottleneck, long long cost) {
+            auto [trains, total] = curve.back();
+            if (cost == slope) curve.pop_back(); // same segment, extended
+            curve.emplace_back(trains + bottleneck, total + bottleneck * cost);
+            slope = cost;
+            return bottleneck;
+        });
+    });
+
+    return trainsWithinBudget(curve, budget);
+}
+
+unsigned int Network::trainsWithinBudget(const vec<std::pair<long long, long long>> &curve, long long budget) {
+    if (curve.empty() || budget < 0) return 0;
+
+    // first breakpoint that costs more than the budget
+    auto it = std::upper_bound(curve.begin(), curve.end(), budget, [](long long b, auto &p) { return b < p.second; });
+    if (it == curve.end()) return (unsigned int) curve.back().first;
+
+    auto &[trains, cost] = *std::prev(it);
+    long long perTrain = (it->second - cost) / (it->first - trains);
+    return (unsigned int) (trains + (budget - cost) / perTrain);
+}
+
+int Network::decomposeFlow(const ptr<Station> &src, const ptr<Station> &dest, const std::function<void(const vec<ptr<Link>> &, int)> &route) {
+    TraceScope scope("decompose flow");
+    std::unordered_map<Station *, int> index;
+    for (int v = 0; v < (int) stations.size(); v++) index[stations[v].get()] = v;
+    if (!index.count(src.get()) || !index.count(dest.get())) return 0;
+
+    // links with net flow, leaving each station
+    vec<vec<std::pair<ptr<Link>, int>>> out(stations.size()); // {link, flow left}
+    for (auto &l : links) {
+        int flow = l->getFlow() - l->getReverse()->getFlow();
+        if (flow > 0) out[index[l->getSrc().get()]].emplace_back(l, flow);
     }
 
-    return max_cost;
+    vec<int> next(stations.size(), 0), onWalk(stations.size(), -1); // first link with flow left, position in the walk
+    vec<std::pair<int, int>> walk; // {station, link taken from it}
+    vec<ptr<Link>> path;
+    int s = index[src.get()], t = index[dest.get()], total = 0;
+
+    int v = s;
+    onWalk[s] = 0;
+    while (true) {
+        if (v == t) {
+            int flow = INT_MAX;
+            for (auto &[u, i] : walk) flow = std::min(flow, out[u][i].second);
+            path.clear();
+            for (auto &[u, i] : walk) out[u][i].second -= flow, path.push_back(out[u][i].first);
+            route(path, flow);
+            total += flow;
+            for (auto &[u, i] : walk) onWalk[u] = -1;
+            onWalk[t] = -1;
+            walk.clear();
+            v = s;
+            onWalk[s] = 0;
+            continue;
+        }
+
+        auto &arcs = out[v];
+        while (next[v] < (int) arcs.size() && arcs[next[v]].second == 0) next[v]++;
+        if (next[v] == (int) arcs.size()) break; // only at src once every route is out, as the flow is conserved
+
+        int w = index[arcs[next[v]].first->getDest().get()];
+        walk.emplace_back(v, next[v]);
+        if (onWalk[w] == -1) {
+            onWalk[w] = (int) walk.size();
+            v = w;
+            continue;
+        }
+
+        // cycle from w back to w: cancel it and walk on from w
+        int flow = INT_MAX;
+        for (int p = onWalk[w]; p < (int) walk.size(); p++) flow = std::min(flow, out[walk[p].first][walk[p].second].second);
+        for (int p = onWalk[w]; p < (int) walk.size(); p++) out[walk[p].first][walk[p].second].second -= flow;
+        for (int p = onWalk[w] + 1; p < (int) walk.size(); p++) onWalk[walk[p].first] = -1;
+        walk.resize(onWalk[w]);
+        v = w;
+    }
+
+    return total;
 }
 
 unsigned int Network::maxFlowReduced(const ptr<Station> &src, const ptr<Station> &dest, const vec<ptr<Station>> &_stations, const vec<ptr<Link>> &_links) {
-    for (auto &s : _stations) s->setEnabled(false);
-    for (auto &l : _links) l->setEnabled(false), l->getReverse()->setEnabled(false);
+    TraceScope scope("max flow reduced");
+    Scenario scenario;
+    for (auto &s : _stations) scenario.disable(s);
+    for (auto &l : _links) scenario.disable(l);
+    return maxFlow(src, dest, scenario);
+}
+
+unsigned int Network::maxFlow(const ptr<Station> &src, const ptr<Station> &dest, const Scenario &scenario) {
+    vec<unsigned int> flows;
+    scenarioFlows(MAX_FLOW_QUERY, src, dest, {&scenario}, flows);
+    return flows[0];
+}
+
+void Network::maxFlow(const ptr<Station> &src, const ptr<Station> &dest, const vec<Scenario> &scenarios, vec<unsigned int> &flows) {
+    vec<const Scenario*> all;
+    for (auto &s : scenarios) all.push_back(&s);
+    scenarioFlows(MAX_FLOW_QUERY, src, dest, all, flows);
+}
 
-    unsigned int max_flow = maxFlow(src, dest);
+unsigned int Network::maxTrains(const ptr<Station> &sink, const Scenario &scenario) {
+    vec<unsigned int> flows;
+    scenarioFlows(MAX_TRAINS_QUERY, nullptr, sink, {&scenario}, flows);
+    return flows[0];
+}
 
-    for (auto &s : _stations) s->setEnabled(true);
-    for (auto &l : _links) l->setEnabled(true), l->getReverse()->setEnabled(true);
+void Network::maxTrains(const ptr<Station> &sink, const vec<Scenario> &scenarios, vec<unsigned int> &flows) {
+    vec<const Scenario*> all;
+    for (auto &s : scenarios) all.push_back(&s);
+    scenarioFlows(MAX_TRAINS_QUERY, nullptr, sink, all, flows);
+}
 
+unsigned int Network::maxFlow(const ptr<Station> &src, const ptr<Station> &dest, FlowAlgorithm algorithm, long long &augmentations) {
+    TraceScope scope("max flow");
+    unsigned int max_flow = 0;
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        typename std::decay_t<decltype(graph)>::Scratch sc;
+        max_flow = (unsigned int) graph.maxFlow(graph.vertex(src), graph.vertex(dest), sc, BIDIRECTIONAL_SEARCH, algorithm);
+        augmentations = sc.augmentations;
+    });
     return max_flow;
 }
 
+unsigned int Network::maxTrains(const ptr<Station> &sink, FlowAlgorithm algorithm, long long &augmentations) {
+    TraceScope scope("max trains");
+    unsigned int max_trains = 0;
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        typename std::decay_t<decltype(graph)>::Scratch sc;
+        int t = graph.vertex(sink);
+        graph.reset(sc);
+        graph.removeArcs(graph.getSinkArcs(t), sc);
+        max_trains = (unsigned int) graph.augment(graph.getSuperSource(), t, sc, FORWARD_SEARCH, algorithm);
+        augmentations = sc.augmentations;
+    });
+    return max_trains;
+}
+
+void Network::scenarioFlows(QueryKind kind, const ptr<Station> &src, const ptr<Station> &dest, const vec<const Scenario*> &scenarios, vec<unsigned int> &flows) {
+    TraceScope scope("scenarios");
+    bool trains = kind == MAX_TRAINS_QUERY;
+    vec<QueryKey> keys(scenarios.size(), queryKey(kind, src, dest));
+    vec<int> missing;
+    long long maxCapacity = 0;
+
+    flows.assign(scenarios.size(), 0);
+    for (int i = 0; i < (int) scenarios.size(); i++) {
+        keys[i].state += scenarios[i]->hash();
+        if (cache.get(keys[i], flows[i])) continue;
+        missing.push_back(i);
+        maxCapacity = std::max(maxCapacity, scenarios[i]->maxCapacity());
+    }
+    if (missing.empty()) return;
+
+    withFlowGraph(stations, links, trains, [&](auto &graph) {
+        int t = graph.vertex(dest), s = trains ? graph.getSuperSource() : graph.vertex(src);
+        vec<int> excluded = trains ? graph.getSinkArcs(t) : vec<int>();
+        vec<typename std::decay_t<decltype(graph)>::Scratch> scratch(workerCount());
+
+        parallelFor((int) missing.size(), [&](int j, int worker) {
+            auto &sc = scratch[worker];
+            graph.reset(sc, *scenarios[missing[j]]);
+            graph.removeArcs(excluded, sc);
+            flows[missing[j]] = (unsigned int) graph.augment(s, t, sc, trains ? FORWARD_SEARCH : BIDIRECTIONAL_SEARCH);
+        });
+    }, maxCapacity);
+
+    for (int i : missing) cache.put(keys[i], flows[i]);
+}
+
 struct CompareStations {
     bool operator()(const ptr<Station> &s1, const ptr<Station> &s2) const {
         return s1->getCost() < s2->getCost();
@@ -233,6 +419,7 @@ struct CompareStations {
 };
 
 bool Network::getAugmentingPathWithCosts(const ptr<Station> &src, const ptr<Station> &dest) {
+    TraceScope scope("dijkstra");
     for (auto &s : stations) s->setVisited(false), s->setPath(nullptr), s->setCost(1000000);
 
     std::priority_queue<ptr<Station>, vec<ptr<Station>>, CompareStations> pq;
@@ -267,23 +454,31 @@ bool Network::getAugmentingPathWithCosts(const ptr<Station> &src, const ptr<Stat
     return dest->isVisited();
 }
 
-void Network::topAffected(const ptr<Link> &l_remove, vec<std::pair<int, int>> &ans) {
+void Network::topAffected(const ptr<Link> &l_remove, vec<std::pair<int, int>> &ans, Progress *progress) {
+    TraceScope scope("top affected");
     vec<std::pair<int, int>> diffs;
     vec<bool> visited(stations.size(), false);
+    Scenario none, without;
+    without.disable(l_remove);
 
     std::queue<ptr<Station>> q;
     q.push(l_remove->getSrc()); q.push(l_remove->getDest());
     visited[l_remove->getSrc()->getId()] = true; visited[l_remove->getDest()->getId()] = true;
 
+    long long done = 0, worst = 0;
     while (!q.empty()) {
+        if (progress) {
+            if (progress->isCancelled()) break;
+            progress->report(done, (long long) stations.size(), worst);
+        }
         auto s = q.front(); q.pop();
-        int flow_before = maxTrains(s);
-        l_remove->setEnabled(false); l_remove->getReverse()->setEnabled(false);
-        int flow_after = maxTrains(s);
-        l_remove->setEnabled(true); l_remove->getReverse()->setEnabled(true);
+        done++;
+        int flow_before = (int) maxTrains(s, none);
+        int flow_after = (int) maxTrains(s, without);
         int diff = flow_before - flow_after;
         if (diff == 0) continue;
         diffs.emplace_back(diff, s->getId());
+        worst = std::max(worst, (long long) diff);
         for (auto &l : s->getLinks()) {
             auto w = l->getDest();
             if (!visited[w->getId()]) {
@@ -293,6 +488,617 @@ void Network::topAffected(const ptr<Link> &l_remove, vec<std::pair<int, int>> &a
         }
     }
 
+    if (progress && q.empty()) progress->report((long long) stations.size(), (long long) stations.size(), worst);
     std::sort(diffs.begin(), diffs.end(), std::greater<>());
     for (int i = 0; i < ans.size() && i < diffs.size(); i++) ans[i] = diffs[i];
 }
+
+void Network::arrivalCapacityRanking(vec<std::pair<int, int>> &ranking) {
+    TraceScope scope("arrival capacity ranking");
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        int ss = graph.getSuperSource();
+        vec<typename std::decay_t<decltype(graph)>::Scratch> scratch(workerCount());
+
+        ranking.assign(ss, {0, 0});
+        parallelFor(ss, [&](int v, int worker) {
+            auto &sc = scratch[worker];
+            graph.reset(sc);
+            graph.removeArcs(graph.getSinkArcs(v), sc);
+            ranking[v] = {(int) graph.augment(ss, v, sc), graph.station(v)->getId()};
+        });
+    });
+
+    std::sort(ranking.begin(), ranking.end(), std::greater<>());
+}
+
+void Network::stationLoad(int samples, unsigned long long seed, vec<std::pair<long long, int>> &load, Progress *progress) {
+    TraceScope scope("station load");
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        int n = graph.size();
+        long long pairs = (long long) n * (n - 1) / 2;
+        bool everyPair = samples <= 0 || samples >= pairs;
+        int tasks = n < 2 ? 0 : everyPair ? n : samples; // with every pair, one task per source station
+
+        vec<typename std::decay_t<decltype(graph)>::Scratch> scratch(workerCount());
+        vec<vec<long long>> through(workerCount(), vec<long long>(n, 0));
+        std::atomic<long long> done(0), largest(0);
+
+        auto solve = [&](int s, int t, int worker) {
+            auto &sc = scratch[worker];
+            graph.reset(sc);
+            long long flow = graph.augment(s, t, sc, BIDIRECTIONAL_SEARCH);
+            if (flow == 0) return;
+            for (int e = 0; e < graph.arcCount(); e++) {
+                long long f = graph.getFlow(e, sc);
+                int v = graph.getHead(e);
+                if (f > 0 && v != t) through[worker][v] += f;
+            }
+            long long l = largest;
+            while (flow > l && !largest.compare_exchange_weak(l, flow));
+        };
+
+        parallelFor(tasks, [&](int i, int worker) {
+            if (progress) {
+                if (progress->isCancelled()) return;
+                progress->report(done++, tasks, largest);
+            }
+            if (everyPair) {
+                for (int t = i + 1; t < n && !(progress && progress->isCancelled()); t++) solve(i, t, worker);
+                return;
+            }
+            std::mt19937_64 rng(sampleSeed(seed, i));
+            int s = (int) (rng() % n), t = (int) (rng() % (n - 1));
+            solve(s, t + (t >= s), worker);
+        });
+
+        load.assign(n, {0, 0});
+        for (int v = 0; v < n; v++) {
+            load[v].second = graph.station(v)->getId();
+            for (auto &w : through) load[v].first += w[v];
+        }
+        if (progress && !progress->isCancelled()) progress->report(tasks, tasks, largest);
+    });
+
+    std::sort(load.begin(), load.end(), [](auto &a, auto &b) {
+        if (a.first != b.first) return a.first > b.first;
+        return a.second < b.second;
+    });
+}
+
+void Network::regionCapacityRanking(bool byDistrict, vec<std::pair<int, std::string>> &ranking) {
+    TraceScope scope("region capacity ranking");
+    ranking.clear();
+    if (stations.empty()) return;
+
+    // a region is cached under the smallest id of its stations, which no other region of the same kind has
+    auto key = queryKey(byDistrict ? DISTRICT_FLOW_QUERY : MUNICIPALITY_FLOW_QUERY, nullptr, stations.front());
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        int ss = graph.getSuperSource();
+        std::map<std::string, vec<int>> regions;
+        for (int v = 0; v < ss; v++) {
+            auto s = graph.station(v);
+            regions[byDistrict ? s->getDistrict() : s->getMunicipality()].push_back(v);
+        }
+
+        vec<std::pair<const vec<int>*, QueryKey>> missing; // {stations of the region, its key}
+        vec<int> slot;                                      // position of each missing region in the ranking
+        for (auto &[name, members] : regions) {
+            key.dest = INT_MAX;
+            for (int v : members) key.dest = std::min(key.dest, graph.station(v)->getId());
+            unsigned int flow = 0;
+            if (!cache.get(key, flow)) missing.emplace_back(&members, key), slot.push_back((int) ranking.size());
+            ranking.emplace_back((int) flow, name);
+        }
+
+        vec<unsigned int> flows(missing.size());
+        vec<typename std::decay_t<decltype(graph)>::Scratch> scratch(workerCount());
+        vec<vec<bool>> targets(workerCount(), vec<bool>(graph.size(), false));
+
+        parallelFor((int) missing.size(), [&](int i, int worker) {
+            auto &sc = scratch[worker];
+            graph.reset(sc);
+            for (int v : *missing[i].first) {
+                targets[worker][v] = true;
+                graph.removeArcs(graph.getSinkArcs(v), sc); // only sources outside the region
+            }
+            flows[i] = graph.augmentToSet(ss, targets[worker], sc);
+            for (int v : *missing[i].first) targets[worker][v] = false;
+        });
+
+        for (int i = 0; i < (int) missing.size(); i++) {
+            cache.put(missing[i].second, flows[i]);
+            ranking[slot[i]].first = (int) flows[i];
+        }
+    });
+
+    std::sort(ranking.begin(), ranking.end(), std::greater<>());
+}
+
+void Network::reliability(const ptr<Station> &src, const ptr<Station> &dest, int samples, unsigned long long seed, ReliabilityReport &report, Progress *progress) {
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        reliability(graph, graph.vertex(src), graph.vertex(dest), {}, samples, seed, report, progress);
+    });
+}
+
+void Network::reliability(const ptr<Station> &sink, int samples, unsigned long long seed, ReliabilityReport &report, Progress *progress) {
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        int t = graph.vertex(sink);
+        vec<int> excluded = graph.getSinkArcs(t);
+        reliability(graph, graph.getSuperSource(), t, excluded, samples, seed, report, progress);
+    });
+}
+
+template<typename Graph>
+void Network::reliability(const Graph &graph, int src, int dest, const vec<int> &excluded, int samples, unsigned long long seed, ReliabilityReport &report, Progress *progress) {
+    TraceScope scope("reliability");
+    typename Graph::Scratch base;
+    graph.reset(base);
+    graph.removeArcs(excluded, base);
+    int baseline = graph.augment(src, dest, base);
+
+    vec<std::pair<int, double>> arcs, vertices; // elements that can fail, with their probability
+    vec<bool> used(graph.size(), false);        // vertices the baseline flow goes through
+    used[src] = used[dest] = true;
+
+    for (int e = 0; e < graph.arcCount(); e += 2) {
+        if (graph.getFlow(e, base) != 0) used[graph.getHead(e)] = used[graph.getTail(e)] = true;
+        if (!graph.link(e)) continue;
+        double p = std::max(graph.link(e)->getFailureProbability(), graph.link(e ^ 1)->getFailureProbability());
+        if (p > 0) arcs.emplace_back(e, p);
+    }
+    for (int v = 0; v < graph.size(); v++)
+        if (graph.station(v) && graph.station(v)->getFailureProbability() > 0) vertices.emplace_back(v, graph.station(v)->getFailureProbability());
+
+    vec<int> values(samples, -1); // -1 for scenarios skipped after a cancel
+    vec<typename Graph::Scratch> scratch(workerCount());
+    for (auto &sc : scratch) graph.reset(sc);
+    std::atomic<long long> done(0);
+
+    parallelFor(samples, [&](int i, int worker) {
+        if (progress) {
+            if (progress->isCancelled()) return;
+            progress->report(done++, samples, baseline);
+        }
+        std::mt19937_64 rng(sampleSeed(seed, i));
+        std::uniform_real_distribution<double> chance(0, 1);
+        vec<int> failedArcs = excluded, failedVertices;
+        bool affected = false;
+
+        for (auto &a : arcs) {
+            if (chance(rng) >= a.second) continue;
+            failedArcs.push_back(a.first);
+            affected |= graph.getFlow(a.first, base) != 0;
+        }
+        for (auto &v : vertices) {
+            if (chance(rng) >= v.second) continue;
+            failedVertices.push_back(v.first);
+            affected |= used[v.first];
+        }
+
+        if (!affected) { values[i] = baseline; return; }
+
+        auto &sc = scratch[worker];
+        sc.residual = base.residual;
+        values[i] = graph.fail(src, dest, baseline, failedArcs, failedVertices, sc);
+    });
+
+    if (progress) progress->report(done, samples, baseline);
+    values.erase(std::remove(values.begin(), values.end(), -1), values.end());
+    samples = (int) values.size();
+
+    report = ReliabilityReport();
+    report.baseline = baseline;
+    report.samples = samples;
+    if (samples == 0) return;
+
+    double sum = 0, squares = 0;
+    for (int v : values) {
+        sum += v; squares += (double) v * v;
+        report.distribution[v]++;
+        if (v == baseline) report.fullService++;
+    }
+    report.mean = sum / samples;
+    report.stddev = samples > 1 ? std::sqrt(std::max(0.0, (squares - samples * report.mean * report.mean) / (samples - 1))) : 0;
+    report.low = report.mean - 1.96 * report.stddev / std::sqrt(samples);
+    report.high = report.mean + 1.96 * report.stddev / std::sqrt(samples);
+    report.fullService /= samples;
+}
+
+void Network::worstLinkPairs(const ptr<Station> &src, const ptr<Station> &dest, int k, vec<LinkPairFailure> &ans, Progress *progress, Checkpoint *checkpoint) {
+    uint64_t key = checkpoint ? Checkpoint::key({fingerprint(), WORST_LINK_PAIRS_SWEEP, (uint64_t) src->getId(), (uint64_t) dest->getId(), (uint64_t) k}) : 0;
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        worstLinkPairs(graph, graph.vertex(src), graph.vertex(dest), {}, k, ans, progress, checkpoint, key);
+    });
+}
+
+void Network::worstLinkPairs(const ptr<Station> &sink, int k, vec<LinkPairFailure> &ans, Progress *progress, Checkpoint *checkpoint) {
+    uint64_t key = checkpoint ? Checkpoint::key({fingerprint(), WORST_LINK_PAIRS_SWEEP, (uint64_t) -1, (uint64_t) sink->getId(), (uint64_t) k}) : 0;
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        int t = graph.vertex(sink);
+        vec<int> excluded = graph.getSinkArcs(t);
+        worstLinkPairs(graph, graph.getSuperSource(), t, excluded, k, ans, progress, checkpoint, key);
+    });
+}
+
+void Network::stationFailures(int k, vec<StationFailure> &ans, Progress *progress) {
+    TraceScope scope("station failures");
+    ans.clear();
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        int ss = graph.getSuperSource();
+        vec<typename std::decay_t<decltype(graph)>::Scratch> base(workerCount()), closed(workerCount());
+        for (auto &sc : closed) graph.reset(sc);
+        vec<vec<std::tuple<int, int, int>>> losses(workerCount()); // {closed station, trains lost, sink}
+        std::atomic<long long> done(0), worst(0);
+
+        parallelFor(ss, [&](int t, int worker) {
+            if (progress) {
+                if (progress->isCancelled()) return;
+                progress->report(done++, ss, worst);
+            }
+            auto &sc = base[worker];
+            graph.reset(sc);
+            vec<int> excluded = graph.getSinkArcs(t);
+            graph.removeArcs(excluded, sc);
+            long long baseline = graph.augment(ss, t, sc);
+            if (baseline == 0) return;
+
+            vec<bool> carries(graph.size(), false); // stations the baseline flow goes through
+            for (int e = 0; e < graph.arcCount(); e += 2) {
+                if (graph.getFlow(e, sc) == 0) continue;
+                carries[graph.getTail(e)] = carries[graph.getHead(e)] = true;
+            }
+
+            for (int c = 0; c < ss; c++) {
+                if (c == t || !carries[c]) continue;
+                closed[worker].residual = sc.residual;
+                int loss = (int) (baseline - graph.fail(ss, t, baseline, excluded, {c}, closed[worker]));
+                if (loss == 0) continue;
+                losses[worker].emplace_back(c, loss, t);
+                long long w = worst;
+                while (loss > w && !worst.compare_exchange_weak(w, loss));
+            }
+        });
+
+        vec<StationFailure> failures(ss);
+        for (auto &list : losses) {
+            for (auto &[c, loss, t] : list) {
+                failures[c].loss += loss;
+                failures[c].affected.emplace_back(loss, graph.station(t)->getId());
+            }
+        }
+        for (int c = 0; c < ss; c++) {
+            auto &f = failures[c];
+            if (f.loss == 0) continue;
+            f.station = graph.station(c);
+            std::sort(f.affected.begin(), f.affected.end(), std::greater<>());
+            if ((int) f.affected.size() > k) f.affected.resize(std::max(k, 0));
+            ans.push_back(std::move(f));
+        }
+        if (progress && !progress->isCancelled()) progress->report(ss, ss, worst);
+    });
+
+    std::sort(ans.begin(), ans.end(), [](const StationFailure &a, const StationFailure &b) {
+        if (a.loss != b.loss) return a.loss > b.loss;
+        return a.station->getId() < b.station->getId();
+    });
+}
+
+template<typename Graph>
+void Network::worstLinkPairs(const Graph &graph, int src, int dest, const vec<int> &excluded, int k, vec<LinkPairFailure> &ans, Progress *progress, Checkpoint *checkpoint, uint64_t key) {
+    TraceScope scope("worst link pairs");
+    typename Graph::Scratch base;
+    graph.reset(base);
+    graph.removeArcs(excluded, base);
+    int baseline = graph.augment(src, dest, base);
+
+    vec<int> candidates, critical; // links, and links carrying flow, strongest first
+    for (int e = 0; e < graph.arcCount(); e += 2) {
+        if (!graph.link(e)) continue;
+        candidates.push_back(e);
+        if (graph.getFlow(e, base) != 0) critical.push_back(e);
+    }
+    std::stable_sort(critical.begin(), critical.end(), [&](int a, int b) { return std::abs(graph.getFlow(a, base)) > std::abs(graph.getFlow(b, base)); });
+    int strongest = critical.empty() ? 0 : (int) std::abs(graph.getFlow(critical[0], base));
+    vec<bool> isCritical(graph.arcCount(), false);
+    for (int e : critical) isCritical[e] = true;
+
+    // best pairs so far, as {-loss, first arc, second arc} (equal losses by arc), and the loss of the k-th one (0 until there are k)
+    std::set<std::tuple<int, int, int>> best;
+    std::atomic<int> threshold(0), worst(0);
+    std::mutex lock;
+
+    auto offer = [&](int loss, int a, int b) {
+        std::lock_guard<std::mutex> guard(lock);
+        worst = std::max(worst.load(), loss);
+        best.emplace(-loss, std::min(a, b), std::max(a, b));
+        if ((int) best.size() > k) best.erase(std::prev(best.end()));
+        if ((int) best.size() == k) threshold = -std::get<0>(*best.rbegin());
+    };
+
+    vec<char> finished(critical.size(), false); // first links whose pairs are all solved
+    vec<long long> state;                       // {number of finished first links, their arcs, then {loss, arc, arc} of the best pairs}
+    if (checkpoint && checkpoint->load(key, state) && !state.empty()) {
+        vec<int> position(graph.arcCount(), -1); // the base flow, and so critical, can differ between runs, but arcs do not
+        for (int i = 0; i < (int) critical.size(); i++) position[critical[i]] = i;
+        size_t p = 1;
+        for (; p <= (size_t) state[0] && p < state.size(); p++)
+            if (state[p] >= 0 && state[p] < graph.arcCount() && position[state[p]] != -1) finished[position[state[p]]] = true;
+        for (; p + 2 < state.size(); p += 3) offer((int) state[p], (int) state[p + 1], (int) state[p + 2]);
+    }
+    auto save = [&]() { // with the lock held
+        state = {0};
+        for (int i = 0; i < (int) critical.size(); i++) if (finished[i]) state.push_back(critical[i]), state[0]++;
+        for (auto &[loss, a, b] : best) state.insert(state.end(), {-loss, a, b});
+        checkpoint->save(key, state);
+    };
+    auto finish = [&](int i) {
+        std::lock_guard<std::mutex> guard(lock);
+        finished[i] = true;
+        if (checkpoint && checkpoint->due()) save();
+    };
+
+    vec<typename Graph::Scratch> first(workerCount()), second(workerCount());
+    for (auto &sc : first) graph.reset(sc);
+    for (auto &sc : second) graph.reset(sc);
+
+    long long total = 2LL * (long long) critical.size(); // single failures, then pairs
+    std::atomic<long long> done(0);
+    auto step = [&]() {
+        if (!progress) return true;
+        if (progress->isCancelled()) return false;
+        progress->report(done++, total, worst);
+        return true;
+    };
+
+    vec<int> single(graph.arcCount(), 0); // flow lost by each link failing alone
+    parallelFor((int) critical.size(), [&](int i, int worker) {
+        if (!step()) return;
+        vec<int> failed = excluded;
+        failed.push_back(critical[i]);
+        first[worker].residual = base.residual;
+        single[critical[i]] = baseline - graph.fail(src, dest, baseline, failed, {}, first[worker]);
+    });
+
+    bool singlesDone = !progress || !progress->isCancelled(); // otherwise no pair can be judged
+    parallelFor(k <= 0 || !singlesDone ? 0 : (int) critical.size(), [&](int i, int worker) {
+        if (finished[i] || !step()) return;
+        int e1 = critical[i];
+        int reach = std::min(baseline, (int) std::abs(graph.getFlow(e1, base)) + strongest);
+        if (reach < threshold || reach <= single[e1]) { // critical-edge bound; ties with the k-th loss are kept, as below
+            finish(i);
+            return;
+        }
+
+        auto &sc1 = first[worker], &sc2 = second[worker];
+        vec<int> failed = excluded;
+        failed.push_back(e1);
+        sc1.residual = base.residual;
+        int flow1 = graph.fail(src, dest, baseline, failed, {}, sc1);
+
+        vec<std::pair<int, int>> order; // {bound, second link}
+        for (int e2 : candidates) {
+            if (e2 == e1 || (isCritical[e2] && e2 < e1)) continue; // each pair of critical links is seen once
+            int f2 = (int) std::abs(graph.getFlow(e2, sc1));
+            if (f2 != 0) order.emplace_back(std::min(baseline, single[e1] + f2), e2); // with no flow, e2 adds no loss
+        }
+        std::sort(order.begin(), order.end(), std::greater<>());
+
+        failed.push_back(0);
+        for (auto &[bound, e2] : order) {
+            if (bound < threshold || (progress && progress->isCancelled())) break; // a tie may still make the k pairs
+            failed.back() = e2;
+            sc2.residual = sc1.residual;
+            int loss = baseline - graph.fail(src, dest, flow1, failed, {}, sc2);
+            if (loss > std::max(single[e1], single[e2])) offer(loss, e1, e2);
+        }
+        if (!progress || !progress->isCancelled()) finish(i);
+    });
+
+    if (checkpoint) {
+        if (progress && progress->isCancelled()) {
+            std::lock_guard<std::mutex> guard(lock);
+            save();
+        }
+        else checkpoint->remove();
+    }
+    if (progress) progress->report(done, total, worst);
+    ans.clear();
+    for (auto &[loss, a, b] : best) ans.push_back({-loss, graph.link(a), graph.link(b)});
+}
+
+unsigned int Network::capacityInvestment(const ptr<Station> &src, const ptr<Station> &dest, int budget, vec<std::pair<int, ptr<Link>>> &upgrades) {
+    unsigned int max_flow = 0;
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        max_flow = capacityInvestment(graph, graph.vertex(src), graph.vertex(dest), {}, budget, upgrades);
+    });
+    return max_flow;
+}
+
+unsigned int Network::capacityInvestment(const ptr<Station> &sink, int budget, vec<std::pair<int, ptr<Link>>> &upgrades) {
+    unsigned int max_flow = 0;
+    withFlowGraph(stations, links, true, [&](auto &graph) {
+        int t = graph.vertex(sink);
+        vec<int> excluded = graph.getSinkArcs(t);
+        max_flow = capacityInvestment(graph, graph.getSuperSource(), t, excluded, budget, upgrades);
+    });
+    return max_flow;
+}
+
+template<typename Graph>
+unsigned int Network::capacityInvestment(const Graph &graph, int src, int dest, const vec<int> &excluded, int budget, vec<std::pair<int, ptr<Link>>> &upgrades) {
+    TraceScope scope("capacity investment");
+    using Cap = std::conditional_t<(sizeof(typename Graph::Capacity) > sizeof(int)), long long, int>;
+    CostFlowGraph<Cap> costs(graph.size());
+    vec<bool> removed(graph.arcCount(), false);
+    for (int e : excluded) removed[e] = removed[e ^ 1] = true;
+
+    vec<std::pair<int, int>> upgradeArcs; // {arc of the link, upgrade arc}
+    for (int e = 0; e < graph.arcCount(); e++) {
+        if (removed[e] || graph.getCapacity(e) == 0) continue;
+        Cap capacity = graph.link(e) ? (Cap) graph.getCapacity(e) : std::numeric_limits<Cap>::max() / 2; // super source arcs stay unbounded after upgrades
+        costs.addArc(graph.getTail(e), graph.getHead(e), capacity, 0);
+        if (budget > 0 && graph.link(e)) upgradeArcs.emplace_back(e, costs.addArc(graph.getTail(e), graph.getHead(e), budget, 1));
+    }
+
+    unsigned int max_flow = 0;
+    long long left = budget;
+    if (src != dest) costs.successiveShortestPaths(src, dest, [&](Cap bottleneck, long long cost) {
+        Cap flow = cost == 0 ? bottleneck : (Cap) std::min<long long>(bottleneck, left / cost);
+        left -= flow * cost;
+        max_flow += flow;
+        return flow;
+    });
+
+    std::map<int, std::pair<int, ptr<Link>>> extra; // both directions of a link share the upgrade
+    for (auto &[e, u] : upgradeArcs) {
+        if (costs.getFlow(u) == 0) continue;
+        extra.emplace(e / 2, std::make_pair(0, graph.link(e & ~1))).first->second.first += costs.getFlow(u);
+    }
+
+    upgrades.clear();
+    for (auto &p : extra) upgrades.push_back(p.second);
+    std::stable_sort(upgrades.begin(), upgrades.end(), [](auto &a, auto &b) { return a.first > b.first; });
+
+    return max_flow;
+}
+
+void Network::allPairsMaxFlow(vec<ptr<Station>> &order, vec<int> &matrix) {
+    TraceScope scope("all pairs max flow");
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        vec<int> terminals(graph.size());
+        std::iota(terminals.begin(), terminals.end(), 0);
+        order.clear();
+        for (int v : terminals) order.push_back(graph.station(v));
+        flowMatrix(graph, terminals, matrix);
+    });
+}
+
+void Network::flowMatrix(const vec<ptr<Station>> &subset, vec<int> &matrix) {
+    TraceScope scope("flow matrix");
+    int n = (int) subset.size();
+    matrix.assign((size_t) n * n, 0);
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        vec<int> terminals, row(n, -1); // distinct vertices of the subset, and the terminal of each station
+        std::unordered_map<int, int> terminal;
+        for (int i = 0; i < n; i++) {
+            int v = subset[i] ? graph.vertex(subset[i]) : -1;
+            if (v == -1) continue;
+            auto [it, added] = terminal.emplace(v, (int) terminals.size());
+            if (added) terminals.push_back(v);
+            row[i] = it->second;
+        }
+
+        vec<int> tree;
+        flowMatrix(graph, terminals, tree);
+        int k = (int) terminals.size();
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (i != j && row[i] != -1 && row[j] != -1) matrix[(size_t) i * n + j] = tree[(size_t) row[i] * k + row[j]];
+            }
+        }
+    });
+}
+
+unsigned int Network::globalMinCut(vec<ptr<Link>> &cut, vec<ptr<Station>> &side) {
+    TraceScope scope("global min cut");
+    cut.clear(); side.clear();
+    long long best = -1;
+    withFlowGraph(stations, links, false, [&](auto &graph) {
+        int n = graph.size();
+        vec<vec<std::pair<int, long long>>> adj(n); // {station, capacity}, of every station merged into a vertex
+        auto weight = [&](int e) { return std::max(graph.getCapacity(e), graph.getCapacity(e ^ 1)); }; // a segment is open if either direction is
+        for (int e = 0; e < graph.arcCount(); e += 2) {
+            if (!graph.link(e) || graph.getTail(e) == graph.getHead(e) || weight(e) == 0) continue;
+            adj[graph.getTail(e)].emplace_back(graph.getHead(e), weight(e));
+            adj[graph.getHead(e)].emplace_back(graph.getTail(e), weight(e));
+        }
+
+        vec<int> owner(n), active; // vertex each station was merged into, and the vertices left
+        vec<vec<int>> members(n);
+        for (int v = 0; v < n; v++) {
+            owner[v] = v, members[v] = {v};
+            if (graph.station(v)->isEnabled() && !adj[v].empty()) active.push_back(v); // stations with no open segment are not part of the railway
+        }
+        vec<long long> key(n);
+        vec<bool> added(n);
+        vec<int> bestSide;
+
+        while (active.size() > 1) {
+            TraceScope phase("phase");
+            std::priority_queue<std::pair<long long, int>> pq;
+            for (int v : active) key[v] = 0, added[v] = false, pq.emplace(0, v);
+
+            int s = -1, t = -1;
+            while (!pq.empty()) {
+                auto [k, v] = pq.top(); pq.pop();
+                if (added[v] || k != key[v]) continue;
+                added[v] = true;
+                s = t; t = v;
+                for (auto &[x, c] : adj[v]) {
+                    int w = owner[x];
+                    if (added[w]) continue;
+                    key[w] += c;
+                    pq.emplace(key[w], w);
+                }
+            }
+
+            if (best == -1 || key[t] < best) best = key[t], bestSide = members[t];
+
+            // merge t into s
+            for (int x : members[t]) owner[x] = s;
+            members[s].insert(members[s].end(), members[t].begin(), members[t].end());
+            adj[s].insert(adj[s].end(), adj[t].begin(), adj[t].end());
+            members[t].clear(); adj[t].clear();
+            adj[s].erase(std::remove_if(adj[s].begin(), adj[s].end(), [&](auto &p) { return owner[p.first] == s; }), adj[s].end());
+            active.erase(std::find(active.begin(), active.end(), t));
+        }
+
+        vec<bool> inSide(n, false);
+        for (int v : bestSide) inSide[v] = true, side.push_back(graph.station(v));
+        for (int e = 0; e < graph.arcCount(); e += 2) {
+            if (!graph.link(e) || weight(e) == 0) continue;
+            int u = graph.getTail(e), w = graph.getHead(e);
+            if (inSide[u] != inSide[w]) cut.push_back(inSide[u] ? graph.link(e) : graph.link(e ^ 1));
+        }
+    });
+
+    return best == -1 ? 0 : (unsigned int) best;
+}
+
+template<typename Graph>
+void Network::flowMatrix(const Graph &graph, const vec<int> &terminals, vec<int> &matrix) {
+    TraceScope scope("flow tree");
+    int k = (int) terminals.size();
+    vec<int> parent(k, 0), weight(k, 0);
+    typename Graph::Scratch sc;
+    vec<bool> side;
+
+    for (int i = 1; i < k; i++) {
+        weight[i] = (int) graph.maxFlow(terminals[i], terminals[parent[i]], sc, BIDIRECTIONAL_SEARCH);
+        graph.sourceSide(terminals[i], sc, side);
+        for (int j = i + 1; j < k; j++)
+            if (parent[j] == parent[i] && side[terminals[j]]) parent[j] = i;
+    }
+
+    vec<vec<std::pair<int, int>>> tree(k); // {neighbour, weight}
+    for (int i = 1; i < k; i++) {
+        tree[i].emplace_back(parent[i], weight[i]);
+        tree[parent[i]].emplace_back(i, weight[i]);
+    }
+
+    matrix.assign((size_t) k * k, 0);
+    parallelFor(k, [&](int r, int) {
+        vec<std::pair<int, int>> stack{{r, -1}}; // {terminal, tree neighbour it was reached from}
+        int *row = &matrix[(size_t) r * k];
+        row[r] = INT_MAX;
+        while (!stack.empty()) {
+            auto [u, from] = stack.back(); stack.pop_back();
+            for (auto &[w, c] : tree[u]) {
+                if (w == from) continue;
+                row[w] = std::min(row[u], c);
+                stack.emplace_back(w, u);
+            }
+        }
+        row[r] = 0;
+    });
+}
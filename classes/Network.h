@@ -4,10 +4,95 @@
 
 
 #include "StationLink.h"
+#include "FlowGraph.h"
+#include "CostFlow.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include "ResultCache.h"
+#include "Progress.h"
+#include "Checkpoint.h"
+
+/**
+ * @brief Reliability Report
+ *
+ * @details Result of a Monte Carlo reliability estimation
+ */
+struct ReliabilityReport {
+    /**
+     * @brief Max flow with no failures
+     */
+    int baseline = 0;
+
+    /**
+     * @brief Number of sampled scenarios
+     */
+    int samples = 0;
+
+    /**
+     * @brief Mean and standard deviation of the max flow over the scenarios
+     */
+    double mean = 0, stddev = 0;
+
+    /**
+     * @brief Bounds of the 95% confidence interval of the mean
+     */
+    double low = 0, high = 0;
+
+    /**
+     * @brief Fraction of the scenarios that keep the baseline flow
+     */
+    double fullService = 0;
+
+    /**
+     * @brief Number of scenarios for each max flow value
+     */
+    std::map<int, int> distribution;
+};
+
+/**
+ * @brief Link Pair Failure
+ *
+ * @details Flow lost when two links fail at the same time
+ */
+struct LinkPairFailure {
+    /**
+     * @brief Flow lost
+     */
+    int loss;
+
+    /**
+     * @brief Links that fail
+     */
+    ptr<Link> first, second;
+};
+
+/**
+ * @brief Station Failure
+ *
+ * @details Arrival capacity lost by the rest of the network when a station closes
+ */
+struct StationFailure {
+    /**
+     * @brief Station that closes
+     */
+    ptr<Station> station;
+
+    /**
+     * @brief Trains lost, added over every other station
+     */
+    int loss;
+
+    /**
+     * @brief Most affected stations, as {trains lost, id}, from the most affected
+     */
+    vec<std::pair<int, int>> affected;
+};
 
 class Network {
 private:
 
+    friend class NetworkBuilder;
+
     /**
      * @brief Vector of stations
      */
@@ -18,6 +103,146 @@ private:
      */
     vec<ptr<Link>> links;
 
+    /**
+     * @brief Input Ids
+     *
+     * @details Id each station had when it was added, indexed by its current id. Empty if the stations were never
+     * renumbered.
+     */
+    vec<int> inputIds;
+
+    /**
+     * @brief Version
+     *
+     * @details Topology version of the network, increased whenever a station or a link is added
+     */
+    std::atomic<unsigned long long> version{0};
+
+    /**
+     * @brief State
+     *
+     * @details Hash of the enabled status, capacities and costs of the stations and links, kept up to date by their
+     * setters (see StateHash)
+     */
+    ptr<StateHash> state = make<StateHash>(0);
+
+    /**
+     * @brief Results of maxFlow, maxCost, maxTrains and regionCapacityRanking
+     */
+    ResultCache cache;
+
+    /**
+     * @brief Query Key
+     *
+     * @param kind Kind of query
+     * @param src Source station (nullptr if unused)
+     * @param dest Destination station
+     *
+     * @return Key of the query in the current state of the network
+     *
+     * @details The key holds the station ids, the version and the state hash of the network (the enabled status of
+     * every station and link, and the capacity, service and cost of every link, by station ids), so results computed
+     * before any of them changed are never returned. The state hash is kept up to date by every change, so building
+     * a key never scans the network. This function has Complexity O(1).
+     */
+    QueryKey queryKey(QueryKind kind, const ptr<Station> &src, const ptr<Station> &dest);
+
+    /**
+     * @brief Scenario Flows
+     *
+     * @param kind MAX_FLOW_QUERY or MAX_TRAINS_QUERY
+     * @param src Source station (unused for max trains)
+     * @param dest Destination station, or sink for max trains
+     * @param scenarios Scenarios to evaluate
+     * @param flows Filled with the result of each scenario
+     *
+     * @details Shared implementation of the scenario queries. Cached results are reused, and the rest are computed
+     * in parallel over a single snapshot of the network.
+     */
+    void scenarioFlows(QueryKind kind, const ptr<Station> &src, const ptr<Station> &dest, const vec<const Scenario*> &scenarios, vec<unsigned int> &flows);
+
+    /**
+     * @brief Reliability
+     *
+     * @param graph Snapshot of the network, of any capacity type
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param excluded Arcs that are always removed
+     * @param samples Number of scenarios
+     * @param seed Random seed
+     * @param report Report to fill
+     * @param progress Progress to report to and cancellation to check (optional)
+     *
+     * @details Shared implementation of both reliability estimations.
+     */
+    template<typename Graph>
+    static void reliability(const Graph &graph, int src, int dest, const vec<int> &excluded, int samples, unsigned long long seed, ReliabilityReport &report, Progress *progress);
+
+    /**
+     * @brief Worst Link Pairs
+     *
+     * @param graph Snapshot of the network, of any capacity type
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param excluded Arcs that are always removed
+     * @param k Number of pairs to report
+     * @param ans Vector to fill
+     * @param progress Progress to report to and cancellation to check (optional)
+     * @param checkpoint File to save the search to and resume it from (optional)
+     * @param key Key of the search in the checkpoint
+     *
+     * @details Shared implementation of both N-2 contingency searches.
+     */
+    template<typename Graph>
+    static void worstLinkPairs(const Graph &graph, int src, int dest, const vec<int> &excluded, int k, vec<LinkPairFailure> &ans, Progress *progress, Checkpoint *checkpoint, uint64_t key);
+
+    /**
+     * @brief Capacity Investment
+     *
+     * @param graph Snapshot of the network, of any capacity type
+     * @param src Source vertex
+     * @param dest Destination vertex
+     * @param excluded Arcs that are always removed
+     * @param budget Extra capacity units available
+     * @param upgrades Vector to fill
+     *
+     * @return Max flow after the upgrades
+     *
+     * @details Shared implementation of both capacity investment optimizations.
+     */
+    template<typename Graph>
+    static unsigned int capacityInvestment(const Graph &graph, int src, int dest, const vec<int> &excluded, int budget, vec<std::pair<int, ptr<Link>>> &upgrades);
+
+    /**
+     * @brief Min Cost Max Flow
+     *
+     * @param graph Snapshot of the network, of any capacity type
+     * @param src Source vertex
+     * @param dest Destination vertex
+     *
+     * @return Min cost of the max flow from src to dest, with the cost of each link
+     *
+     * @details Solves the flow with cost scaling (see CostFlowGraph::costScaling) and leaves it on the links.
+     */
+    template<typename Graph>
+    static long long minCostMaxFlow(const Graph &graph, int src, int dest);
+
+    /**
+     * @brief Flow Matrix
+     *
+     * @param graph Snapshot of the network, of any capacity type
+     * @param terminals Vertices to compute the max flows between
+     * @param matrix Filled with the max flow between every pair of terminals, row by row (0 on the diagonal)
+     *
+     * @details Builds a Gusfield flow-equivalent tree of the terminals with one max flow per terminal: each terminal is
+     * cut from its current tree neighbour, and the later terminals on its side of the min cut are moved under it.
+     * The max flow between two terminals is then the lightest edge on their tree path, read with a walk of the tree
+     * from every terminal, in parallel.
+     * This function has Complexity O(T * VE^2 + T^2) where T is the number of terminals.
+     */
+    template<typename Graph>
+    static void flowMatrix(const Graph &graph, const vec<int> &terminals, vec<int> &matrix);
+
 public:
 
     /**
@@ -80,6 +305,40 @@ public:
      */
     ptr<Station> getStation(int id);
 
+    /**
+     * @brief Get Version
+     *
+     * @return Topology version of the network, increased whenever a station or a link is added
+     */
+    unsigned long long getVersion() const;
+
+    /**
+     * @brief Fingerprint
+     *
+     * @return Hash of the ids and enabled status of the stations, and of the endpoints, capacity, service and enabled
+     * status of the links in order
+     *
+     * @details Unlike the version and the query keys, it is the same in every run that reads the same dataset, so it
+     * identifies the network in checkpoints. This function has Complexity O(V + E).
+     */
+    unsigned long long fingerprint() const;
+
+    /**
+     * @brief Get Result Cache
+     *
+     * @return Cache of the results of maxFlow, maxCost, maxTrains and regionCapacityRanking (for statistics, or to clear it)
+     */
+    ResultCache &getResultCache();
+
+    /**
+     * @brief Get Input Id
+     *
+     * @param id Station ID
+     *
+     * @return Id the station had when it was added, before the stations were renumbered by NetworkBuilder
+     */
+    int getInputId(int id);
+
     /**
      * @brief Get Station
      *
@@ -117,8 +376,11 @@ public:
      *
      * @return Max flow between src and dest
      *
-     * @details Returns the maximum flow between two stations.
+     * @details Returns the maximum flow between two stations, solved with Edmonds-Karp on a snapshot of the network
+     * (see FlowGraph), the model allPairsMaxFlow and the flow matrix use too, so every menu gives the same answer.
      * This function has Complexity O(VE^2) where V is the number of vertices and E is the number of edges.
+     * Results are cached, and repeated queries on an unchanged network take O(1). The flow of each link is not set
+     * (see trainRoutes).
      */
     unsigned int maxFlow(const ptr<Station> &src, const ptr<Station> &dest);
 
@@ -128,12 +390,65 @@ public:
      * @param src Source station
      * @param dest Destination station
      *
-     * @return Cost of flow between src and dest
+     * @return Min cost of the max flow between src and dest
+     *
+     * @details Returns the cost of running the max number of trains between two stations as cheaply as possible, with
+     * the cost of each link (Link::getCost). The flow is found with cost scaling, so wide cost ranges, such as
+     * per-link operating costs read from the network file, do not slow it down.
+     * This function has Complexity O(V^2 E log(VC)) where C is the largest cost of a link.
+     * Results are cached, and repeated queries on an unchanged network take O(V + E). A cached result does not leave
+     * the flow of each link set.
+     */
+    long long maxCost(const ptr<Station> &src, const ptr<Station> &dest);
+
+    /**
+     * @brief Train Routes
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param minCost true for the flow of maxCost (max trains at min cost), false for the flow of maxFlow
+     * @param route Called with each route, as its links from src to dest, and the number of trains it takes
+     *
+     * @return Number of trains sent, added over every route
+     *
+     * @details Solves the flow again, without the cache, so the flow of each link is set, and streams its
+     * decomposition (see decomposeFlow).
+     * This function has the Complexity of maxFlow or maxCost, plus that of decomposeFlow.
+     */
+    unsigned int trainRoutes(const ptr<Station> &src, const ptr<Station> &dest, bool minCost, const std::function<void(const vec<ptr<Link>> &, int)> &route);
+
+    /**
+     * @brief Budget Trains
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param budget Operating cost available
+     * @param curve Vector with the breakpoints of the min cost curve, as {trains, min cost}, from {0, 0} to the max
+     * flow and its min cost (the result of maxCost)
+     *
+     * @return Max trains between src and dest whose min cost fits in the budget
+     *
+     * @details Grows a min-cost flow from src to dest with successive shortest paths, with the cost of each link
+     * (Link::getCost). Each path costs at least as much per train as the one before it, so the min cost of running
+     * k trains is piecewise-linear and convex in k, and the paths are its segments. The whole curve is traced in one
+     * run, with consecutive segments of the same cost per train merged, so other budgets can be answered from it with
+     * trainsWithinBudget instead of solving again.
+     * This function has Complexity O(P * E log(V)) where P is the number of augmentations.
+     */
+    unsigned int budgetTrains(const ptr<Station> &src, const ptr<Station> &dest, long long budget, vec<std::pair<long long, long long>> &curve);
+
+    /**
+     * @brief Trains Within Budget
+     *
+     * @param curve Breakpoints of a min cost curve, as filled by budgetTrains
+     * @param budget Operating cost available
      *
-     * @details Returns the cost between two stations.
-     * This function has Complexity O(V(E^2)log(V)) where V is the number of vertices and E is the number of edges.
+     * @return Max trains whose min cost fits in the budget
+     *
+     * @details Finds the segment of the curve the budget ends in, and how many whole trains of that segment it pays for.
+     * This function has Complexity O(log(S)) where S is the number of segments.
      */
-    unsigned int maxCost(const ptr<Station> &src, const ptr<Station> &dest);
+    static unsigned int trainsWithinBudget(const vec<std::pair<long long, long long>> &curve, long long budget);
 
     /**
      * @brief Get Max Flow Reduced
@@ -145,7 +460,8 @@ public:
      *
      * @return Max flow between src and dest
      *
-     * @details Returns the maximum flow between two stations.
+     * @details Returns the maximum flow between two stations with the given stations and links out of service. They are
+     * applied as a scenario, so no enabled status is changed. Results are cached.
      * This function has Complexity O(VE^2) where V is the number of vertices and E is the number of edges.
      *
      * @warning This function is used for the reduced network.
@@ -153,20 +469,49 @@ public:
     unsigned int maxFlowReduced(const ptr<Station> &src, const ptr<Station> &dest, const vec<ptr<Station>> &_stations, const vec<ptr<Link>> &_links);
 
     /**
-     * @brief Get Augmenting Path
+     * @brief Get Max Flow in a Scenario
      *
      * @param src Source station
      * @param dest Destination station
+     * @param scenario Stations and links out of service and capacity changes
      *
-     * @return true if path exists
-     * @return false if path does not exist
+     * @return Max flow between src and dest in the scenario (0 if src or dest is out of service)
      *
-     * @details Returns true if an augmenting path exists between two stations.
-     * This function has Complexity O(V + E) where V is the number of vertices and E is the number of edges
+     * @details Solves the flow on a snapshot of the network with the scenario applied, so the network is never
+     * modified and scenarios can be evaluated from several threads at the same time. Results are cached.
+     * This function has Complexity O(VE^2) where V is the number of vertices and E is the number of edges.
+     */
+    unsigned int maxFlow(const ptr<Station> &src, const ptr<Station> &dest, const Scenario &scenario);
+
+    /**
+     * @brief Get Max Flow in many Scenarios
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param scenarios Scenarios to evaluate
+     * @param flows Filled with the max flow between src and dest in each scenario
      *
-     * @warning This function is used for the Ford-Fulkerson algorithm.
+     * @details Evaluates the scenarios in parallel over a single snapshot of the network.
+     * This function has Complexity O(S * VE^2 / T) where S is the number of scenarios and T the number of threads.
      */
-    bool getAugmentingPath(const ptr<Station> &src, const ptr<Station> &dest);
+    void maxFlow(const ptr<Station> &src, const ptr<Station> &dest, const vec<Scenario> &scenarios, vec<unsigned int> &flows);
+
+    /**
+     * @brief Get Max Flow with an Algorithm
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param algorithm Augmenting path algorithm (see FlowAlgorithm)
+     * @param augmentations Set to the number of augmenting paths the algorithm pushed
+     *
+     * @return Max flow between src and dest
+     *
+     * @details Solves the flow on a snapshot of the network with the given algorithm, to compare the algorithms.
+     * Results are not cached, as the augmentations are counted on every call.
+     * This function has Complexity O(VE^2) for Edmonds-Karp and O(E^2 log(U)) for capacity scaling, where U is the
+     * largest capacity.
+     */
+    unsigned int maxFlow(const ptr<Station> &src, const ptr<Station> &dest, FlowAlgorithm algorithm, long long &augmentations);
 
     /**
      * @brief Get Augmenting Path with Costs
@@ -185,36 +530,31 @@ public:
     bool getAugmentingPathWithCosts(const ptr<Station> &src, const ptr<Station> &dest);
 
     /**
-     * @brief Get Bottleneck
+     * @brief Decompose Flow
+     *
      * @param src Source station
      * @param dest Destination station
+     * @param route Called with each route, as its links from src to dest, and the number of trains it takes
      *
-     * @return Bottleneck of path between src and dest
+     * @return Number of trains sent, added over every route
      *
-     * @details The path info is stored in each station with the parameter 'path': each stations saves the edge that 'discovered' it.
-     * The time complexity is O(n), where n is the number of stations in the path.
+     * @details Splits the flow left on the links (by an uncached maxFlow or maxCost) into routes from src to dest.
+     * The flows of a link and its reverse are netted first, then routes are walked from src along links with flow
+     * left: reaching dest sends the bottleneck of the walk, and coming back to a station of the walk cancels the
+     * cycle, so no route repeats a station. The link flows are not changed, and the route passed to the callback is
+     * only valid during the call.
+     * This function has Complexity O(E * P) where P is the number of routes and cycles cancelled.
      */
-    static int getBottleneck(const ptr<Station> &src, const ptr<Station> &dest);
-
-    /**
-     * @brief Update Path
-     *
-     * @param source Source station
-     * @param dest Destination station
-     * @param flow Flow to be added
-     * @param cost Cost of flow
-     *
-     * @details Updates the path between two stations.
-     * This function has Complexity O(n) where n is the number of stations in the path.
-     */
-    static void updatePath(const ptr<Station> &source, const ptr<Station> &dest, int flow, unsigned int *cost = nullptr);
+    int decomposeFlow(const ptr<Station> &src, const ptr<Station> &dest, const std::function<void(const vec<ptr<Link>> &, int)> &route);
 
     /**
      * @brief Get Max Flow Network
      *
      * @param pairs Vector of pairs of stations
+     * @param progress Reports the pairs evaluated and the best flow so far, and can cancel the search (optional)
+     * @param checkpoint File the search saves its position, best flow and best pairs to, and resumes from (optional)
      *
-     * @return Max flow network
+     * @return Max flow network (the best found before a cancel)
      *
      * @details Returns the max flow network.
      * This function has Complexity O(V^3 * E^2), as we need to run Edmonds-Karp algorithm for each pair of stations.
@@ -222,9 +562,12 @@ public:
      * However, we start with the "most promising" stations (the ones that have more incoming capacity) in order to greatly prune our search space.
      * This technique is in fact efficient because we noticed a great improvement over the simple brute force (the running time improved from ~20s to ~0.12s)
      *
+     * With a checkpoint, the search resumes from the last save for the same network, saves again on every interval and
+     * when cancelled, and removes the file once complete.
+     *
      * @warning This is FAST!!!
      */
-    unsigned int getMaxFlowNetwork(vec<std::pair<ptr<Station>, ptr<Station>>>& pairs);
+    unsigned int getMaxFlowNetwork(vec<std::pair<ptr<Station>, ptr<Station>>>& pairs, Progress *progress = nullptr, Checkpoint *checkpoint = nullptr);
 
     /**
      * @brief Get Max Trains
@@ -233,42 +576,279 @@ public:
      *
      * @return Max trains
      *
-     * @details Returns the max trains that can be sent to a sink station from all sources in the network.
+     * @details Returns the max trains that can be sent to a sink station from all sources in the network. The super
+     * source linking the sources is added to a snapshot of the network (see FlowGraph), never to the network itself.
      * This function has Complexity O(VE^2) where V is the number of vertices and E is the number of edges.
+     * Results are cached, and repeated queries on an unchanged network take O(V + E). The flow of each link is not set.
      */
     unsigned int maxTrains(const ptr<Station>& sink);
 
     /**
-     * @brief Create Super Source
+     * @brief Get Max Trains in a Scenario
      *
-     * @param sources Vector of sources stations
+     * @param sink Sink station
+     * @param scenario Stations and links out of service and capacity changes
      *
-     * @return A pseudo Station which is a Super Source
+     * @return Max trains that can arrive at sink in the scenario
      *
-     * @details Creates a super source from a vector of source stations and adds it to the network.
-     * This function as Complexity O(n) where n is the number of stations passed as parameter
+     * @details Same as maxTrains, without modifying the network (see maxFlow with a scenario).
+     * This function has Complexity O(VE^2) where V is the number of vertices and E is the number of edges.
      */
-    void createSuperSource(ptr<Station> &ss, const vec<ptr<Station>> &sources);
+    unsigned int maxTrains(const ptr<Station> &sink, const Scenario &scenario);
 
     /**
-     * @brief Remove Super Source
+     * @brief Get Max Trains in many Scenarios
      *
-     * @param superSource Super source
+     * @param sink Sink station
+     * @param scenarios Scenarios to evaluate
+     * @param flows Filled with the max trains that can arrive at sink in each scenario
      *
-     * @details Removes a super source from the network. This function as Complexity O(n) where n is size of the adjacency list of the super source
+     * @details Evaluates the scenarios in parallel over a single snapshot of the network.
+     * This function has Complexity O(S * VE^2 / T) where S is the number of scenarios and T the number of threads.
      */
-    void removeSuperSource(ptr<Station>& superSource);
+    void maxTrains(const ptr<Station> &sink, const vec<Scenario> &scenarios, vec<unsigned int> &flows);
+
+    /**
+     * @brief Get Max Trains with an Algorithm
+     *
+     * @param sink Sink station
+     * @param algorithm Augmenting path algorithm (see FlowAlgorithm)
+     * @param augmentations Set to the number of augmenting paths the algorithm pushed
+     *
+     * @return Max trains that can arrive at sink
+     *
+     * @details Same as maxTrains, with the given algorithm (see maxFlow with an algorithm). Results are not cached.
+     * This function has Complexity O(VE^2) for Edmonds-Karp and O(E^2 log(U)) for capacity scaling, where U is the
+     * largest capacity.
+     */
+    unsigned int maxTrains(const ptr<Station> &sink, FlowAlgorithm algorithm, long long &augmentations);
 
     /**
      * @brief Get k-top affected stations by the removal of a link
      *
      * @param l_remove Link to be removed
      * @param ans Vector of pairs of stations and the respective flow that would be lost
+     * @param progress Reports the stations processed and the largest loss so far, and can cancel the search (optional)
      *
-     * @details This function returns the k-top affected stations by the removal of a link.
+     * @details This function returns the k-top affected stations by the removal of a link. The removal is evaluated as
+     * a scenario, so the link is never disabled. A cancelled search returns the stations processed so far.
      * This function has Complexity O(V^2 * E^2) where V is the number of vertices and E is the number of edges.
      */
-    void topAffected(const ptr<Link>& l_remove, vec<std::pair<int, int>> &ans);
+    void topAffected(const ptr<Link>& l_remove, vec<std::pair<int, int>> &ans, Progress *progress = nullptr);
+
+    /**
+     * @brief Arrival Capacity Ranking
+     *
+     * @param ranking Vector of pairs with the max trains of each station and its id, sorted from the highest to the lowest
+     *
+     * @details Computes maxTrains for every station in the network.
+     * The source stations and the super source are built once, in a snapshot of the network, and the stations are then
+     * split between all available threads, each one with its own residual graph.
+     * This function has Complexity O(V^2 * E^2 / T) where T is the number of threads.
+     */
+    void arrivalCapacityRanking(vec<std::pair<int, int>> &ranking);
+
+    /**
+     * @brief Station Load
+     *
+     * @param samples Number of pairs of stations to sample (0, or at least the number of pairs, for every pair)
+     * @param seed Random seed
+     * @param load Vector of pairs with the trains going through each station and its id, from the highest to the lowest
+     * @param progress Reports the pairs (or, with every pair, the source stations) evaluated and the largest max flow
+     * so far, and can cancel the computation (optional)
+     *
+     * @details Flow betweenness: the max flow of each pair is solved, and every station other than the pair gets the
+     * trains that enter it. With sampling the loads are totals over the sampled pairs, so they rank the stations as
+     * the full measure would, scaled by the fraction sampled.
+     * Pairs are solved in parallel over one snapshot of the network, each thread reusing its own residual graph and
+     * adding to its own loads. Every sample draws from its own generator, seeded from the seed and the sample number,
+     * so the loads are the same for the same seed no matter how the pairs are split between threads.
+     * A cancelled computation returns the loads of the pairs evaluated before the cancel.
+     * This function has Complexity O(P * VE^2 / T) where P is the number of pairs and T is the number of threads.
+     */
+    void stationLoad(int samples, unsigned long long seed, vec<std::pair<long long, int>> &load, Progress *progress = nullptr);
+
+    /**
+     * @brief Region Capacity Ranking
+     *
+     * @param byDistrict true to rank districts, false to rank municipalities
+     * @param ranking Vector of pairs with the max flow of each region and its name, sorted from the highest to the lowest
+     *
+     * @details The max flow of a region is the max flow between the source stations outside it (the ones used by
+     * maxTrains) and a super sink linked to all of its stations. Since every link carries the same capacity in both
+     * directions, this is both the flow the network can bring into the region and the flow it can take out of it.
+     * Regions are computed in parallel, and their results are kept in the result cache like any other query.
+     * This function has Complexity O(R * V * E^2 / T) where R is the number of regions and T is the number of threads.
+     */
+    void regionCapacityRanking(bool byDistrict, vec<std::pair<int, std::string>> &ranking);
+
+    /**
+     * @brief Reliability
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param samples Number of scenarios
+     * @param seed Random seed
+     * @param report Report with the distribution of the max flow between src and dest
+     * @param progress Reports the scenarios evaluated and the baseline, and can cancel the estimation (optional)
+     *
+     * @details Monte Carlo estimation of the max flow between two stations when stations and links fail at random,
+     * each one with its own failure probability (a link fails in both directions, with the largest probability of the two).
+     * Every scenario draws from its own generator, seeded from the seed and the scenario number, so the report is the
+     * same for the same seed no matter how the scenarios are split between threads.
+     * Scenarios are evaluated in parallel and warm started from the flow with no failures: a scenario whose failures
+     * carry no flow keeps the baseline, and the others only reroute the flow of the failed elements.
+     * A cancelled estimation reports only the scenarios evaluated before the cancel.
+     * This function has Complexity O(S * (V + E) / T) in most scenarios, and O(S * VE^2 / T) in the worst case,
+     * where S is the number of scenarios and T is the number of threads.
+     */
+    void reliability(const ptr<Station> &src, const ptr<Station> &dest, int samples, unsigned long long seed, ReliabilityReport &report, Progress *progress = nullptr);
+
+    /**
+     * @brief Reliability
+     *
+     * @param sink Sink station
+     * @param samples Number of scenarios
+     * @param seed Random seed
+     * @param report Report with the distribution of the max trains that can arrive at sink
+     * @param progress Reports the scenarios evaluated and the baseline, and can cancel the estimation (optional)
+     *
+     * @details Same as the pair version, but for maxTrains.
+     */
+    void reliability(const ptr<Station> &sink, int samples, unsigned long long seed, ReliabilityReport &report, Progress *progress = nullptr);
+
+    /**
+     * @brief Worst Link Pairs
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param k Number of pairs to report
+     * @param ans Vector with the k pairs of links whose simultaneous failure loses the most flow between src and dest,
+     * sorted from the largest to the smallest loss
+     * @param progress Reports the links evaluated and the largest loss so far, and can cancel the search (optional)
+     * @param checkpoint File the search saves the first links done and the best pairs to, and resumes from (optional)
+     *
+     * @details N-2 contingency search. Only pairs that lose more together than each of their links alone are reported,
+     * since the others are already covered by single link failures.
+     * Instead of solving every pair of links, only pairs where the first link carries flow in the baseline max flow
+     * are considered, since failing links with no flow loses nothing.
+     * For each of these links, the flow without it is warm started from the baseline; a second link with no flow in
+     * that solution adds no loss, and any other is bounded by the loss of the first plus its own flow. Pairs whose bound
+     * cannot reach the current k-th loss are pruned, and the first links are split between all available threads.
+     * Pairs that tie with the k-th loss are never pruned and ties are broken by the links, so every run returns the
+     * same k pairs however the threads are scheduled.
+     * This function has Complexity O(C * E * VE^2 / T) in the worst case, where C is the number of links carrying flow
+     * and T is the number of threads, but only a small fraction of the pairs is ever solved.
+     * A cancelled search returns the worst pairs found so far (only those loaded from the checkpoint, if any, if it was
+     * cancelled before every single link failure was solved). With a checkpoint, the search resumes from the last save for the same network, stations
+     * and k, saves again on every interval and when cancelled, and removes the file once complete.
+     */
+    void worstLinkPairs(const ptr<Station> &src, const ptr<Station> &dest, int k, vec<LinkPairFailure> &ans, Progress *progress = nullptr, Checkpoint *checkpoint = nullptr);
+
+    /**
+     * @brief Worst Link Pairs
+     *
+     * @param sink Sink station
+     * @param k Number of pairs to report
+     * @param ans Vector with the k pairs of links whose simultaneous failure loses the most trains arriving at sink
+     * @param progress Reports the links evaluated and the largest loss so far, and can cancel the search (optional)
+     * @param checkpoint File the search saves the first links done and the best pairs to, and resumes from (optional)
+     *
+     * @details Same as the pair version, but for maxTrains.
+     */
+    void worstLinkPairs(const ptr<Station> &sink, int k, vec<LinkPairFailure> &ans, Progress *progress = nullptr, Checkpoint *checkpoint = nullptr);
+
+    /**
+     * @brief Station Failures
+     *
+     * @param k Number of affected stations to report for each closure
+     * @param ans Vector with every station whose closure loses trains, from the largest loss
+     * @param progress Reports the stations evaluated and the largest loss of one station so far, and can cancel the
+     * search (optional)
+     *
+     * @details N-1 contingency search over the stations: the loss of a closure is how much the maxTrains of every
+     * other station drops when the station closes (its own arrivals are not counted).
+     * The work is split by sink, so each baseline is solved once and shared by every closure. A closure can only
+     * lower the flow of a sink if the baseline flow goes through it, so only those stations are failed, each one a
+     * warm start from the baseline (see FlowGraph::fail). A cancelled search returns the sinks evaluated so far.
+     * This function has Complexity O(V * (VE^2 + C * F * (V + E)) / T) where C is the number of stations carrying
+     * the baseline flow of a sink, F the flow through them and T the number of threads.
+     */
+    void stationFailures(int k, vec<StationFailure> &ans, Progress *progress = nullptr);
+
+    /**
+     * @brief Capacity Investment
+     *
+     * @param src Source station
+     * @param dest Destination station
+     * @param budget Extra capacity units available
+     * @param upgrades Vector with the extra capacity to give each link and the link, sorted from the largest upgrade
+     *
+     * @return Max flow between src and dest after the upgrades
+     *
+     * @details Chooses which links to upgrade, one capacity unit at a time, so that the max flow between src and dest
+     * grows the most. Every link gets a parallel upgrade arc with unlimited capacity and a cost of 1 per unit, and a
+     * min-cost flow is grown with successive shortest paths: the first paths are free (the current max flow), and each
+     * later one costs the number of links it needs upgraded per extra train. Since these costs never decrease, stopping
+     * when the next train no longer fits in the budget gives the largest gain possible, without trying upgrades one by one.
+     * This function has Complexity O((F + B) * E log(V)) where F is the max flow and B is the budget.
+     */
+    unsigned int capacityInvestment(const ptr<Station> &src, const ptr<Station> &dest, int budget, vec<std::pair<int, ptr<Link>>> &upgrades);
+
+    /**
+     * @brief Capacity Investment
+     *
+     * @param sink Sink station
+     * @param budget Extra capacity units available
+     * @param upgrades Vector with the extra capacity to give each link and the link, sorted from the largest upgrade
+     *
+     * @return Max trains that can arrive at sink after the upgrades
+     *
+     * @details Same as the pair version, but for maxTrains.
+     */
+    unsigned int capacityInvestment(const ptr<Station> &sink, int budget, vec<std::pair<int, ptr<Link>>> &upgrades);
+
+    /**
+     * @brief All Pairs Max Flow
+     *
+     * @param order Filled with the stations, in the order of the rows and columns of the matrix
+     * @param matrix Filled with the max flow between every pair of stations, row by row (0 on the diagonal)
+     *
+     * @details Computes every max flow of the network with V - 1 max flows instead of one per pair, through a
+     * Gusfield flow-equivalent tree (the links are undirected, so the tree holds every pair's min cut).
+     * This function has Complexity O(V^2 E^2).
+     */
+    void allPairsMaxFlow(vec<ptr<Station>> &order, vec<int> &matrix);
+
+    /**
+     * @brief Flow Matrix
+     *
+     * @param subset Stations to compute the max flows between (hubs)
+     * @param matrix Filled with the max flow between every pair of stations of the subset, row by row, in the order
+     * of the subset (0 on the diagonal, and for stations that are repeated or not in the network)
+     *
+     * @details Same as allPairsMaxFlow, but the flow-equivalent tree only holds the stations of the subset, so it
+     * takes one max flow per station of the subset, whatever the size of the network.
+     * This function has Complexity O(S * VE^2 + S^2) where S is the size of the subset.
+     */
+    void flowMatrix(const vec<ptr<Station>> &subset, vec<int> &matrix);
+
+    /**
+     * @brief Global Min Cut
+     *
+     * @param cut Filled with the links of the cut, each one leaving side
+     * @param side Filled with the stations on one side of the cut (the smaller one is not guaranteed)
+     *
+     * @return Smallest total capacity of the links whose failure splits the network in two (0 if it already is)
+     *
+     * @details Stoer-Wagner over the segments of the network, each one an undirected edge with the capacity of its
+     * link or of its reverse, whichever is larger. Disabled stations, segments disabled both ways, and stations with
+     * no segment left are not part of the railway. Every phase adds the stations in order of how strongly they are
+     * linked to the ones already added, with a heap, and the last one gives a cut; the last two are then merged.
+     * The lightest cut of all V - 1 phases is the global min cut, without a max flow between any pair.
+     * This function has Complexity O(V * E log(E)).
+     */
+    unsigned int globalMinCut(vec<ptr<Link>> &cut, vec<ptr<Station>> &side);
 };
 
 
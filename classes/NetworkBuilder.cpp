@@ -0,0 +1,138 @@
+#include "NetworkBuilder.h"
+
+namespace {
+    /**
+     * @brief Hash of an unordered pair of stations
+     */
+    struct PairHash {
+        size_t operator()(const std::pair<Station*, Station*> &p) const {
+            return std::hash<Station*>()(p.first) * 31 + std::hash<Station*>()(p.second);
+        }
+    };
+
+    std::pair<Station*, Station*> key(Station *a, Station *b) {
+        return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+    }
+}
+
+void NetworkBuilder::addStation(const ptr<Station> &station) {
+    stations.push_back(station);
+}
+
+void NetworkBuilder::addLink(const ptr<Station> &st1, const ptr<Station> &st2, int capacity, int service) {
+    links.push_back({st1, st2, capacity, service});
+}
+
+void NetworkBuilder::addLinks(const vec<LinkRecord> &records) {
+    links.insert(links.end(), records.begin(), records.end());
+}
+
+void NetworkBuilder::setOrder(StationOrder _order) {
+    order = _order;
+}
+
+vec<int> NetworkBuilder::permutation(const ptr<Network> &network) const {
+    auto &all = network->stations;
+    int n = (int) all.size();
+    std::unordered_map<Station*, int> position;
+    for (int i = 0; i < n; i++) position[all[i].get()] = i;
+
+    vec<vec<int>> adj(n);
+    for (int i = 0; i < (int) network->links.size(); i += 2) {
+        auto a = position.find(network->links[i]->getSrc().get()), b = position.find(network->links[i]->getDest().get());
+        if (a == position.end() || b == position.end() || a->second == b->second) continue;
+        adj[a->second].push_back(b->second);
+        adj[b->second].push_back(a->second);
+    }
+
+    vec<int> ans;
+    vec<bool> visited(n, false);
+    auto bfs = [&](int s) {
+        size_t i = ans.size();
+        visited[s] = true;
+        ans.push_back(s);
+        for (; i < ans.size(); i++)
+            for (int w : adj[ans[i]])
+                if (!visited[w]) { visited[w] = true; ans.push_back(w); }
+    };
+
+    if (order == RCM_ORDER) {
+        auto byDegree = [&](int a, int b) { return adj[a].size() < adj[b].size(); };
+        for (auto &list : adj) std::stable_sort(list.begin(), list.end(), byDegree);
+        vec<int> starts(n);
+        std::iota(starts.begin(), starts.end(), 0);
+        std::stable_sort(starts.begin(), starts.end(), byDegree); // each component starts at its lowest degree
+        for (int s : starts) if (!visited[s]) bfs(s);
+        std::reverse(ans.begin(), ans.end());
+    }
+    else {
+        for (int s = 0; s < n; s++) if (!visited[s]) bfs(s);
+        if (order == DISTRICT_ORDER)
+            std::stable_sort(ans.begin(), ans.end(), [&](int a, int b) { return all[a]->getDistrict() < all[b]->getDistrict(); });
+    }
+    return ans;
+}
+
+ptr<Network> NetworkBuilder::build() {
+    TraceScope scope("build network");
+    auto network = make<Network>();
+
+    std::unordered_set<int> ids;
+    ids.reserve(stations.size());
+    network->stations.reserve(stations.size());
+    for (auto &s : stations)
+        if (ids.insert(s->getId()).second) network->stations.push_back(s);
+
+    // links the stations already had, which addLink would also refuse to duplicate
+    std::unordered_set<std::pair<Station*, Station*>, PairHash> pairs;
+    pairs.reserve(links.size());
+    std::unordered_set<Station*> ends;
+    for (auto &r : links) {
+        for (auto &s : {r.src, r.dest}) {
+            if (!ends.insert(s.get()).second) continue;
+            for (auto &l : s->getLinks()) pairs.insert(key(l->getSrc().get(), l->getDest().get()));
+        }
+    }
+
+    network->links.reserve(2 * links.size());
+    for (auto &r : links) {
+        if (!pairs.insert(key(r.src.get(), r.dest.get())).second) continue;
+        auto link = make<Link>(r.src, r.dest, r.capacity, r.service);
+        auto rev = make<Link>(r.dest, r.src, r.capacity, r.service);
+        link->setReverse(rev); rev->setReverse(link);
+        for (auto &l : {link, rev}) l->setCost(r.cost), l->setDistance(r.distance), l->setEnergy(r.energy);
+        network->links.push_back(link); network->links.push_back(rev);
+        r.src->addLink(link); r.dest->addLink(rev);
+    }
+
+    if (order != INPUT_ORDER) {
+        auto perm = permutation(network);
+        vec<ptr<Station>> ordered;
+        for (int i = 0; i < (int) perm.size(); i++) {
+            ordered.push_back(network->stations[perm[i]]);
+            network->inputIds.push_back(ordered[i]->getId());
+            ordered[i]->setId(i);
+        }
+        network->stations = ordered;
+
+        vec<int> pairs(network->links.size() / 2); // links sorted by their stations, keeping each link by its reverse
+        std::iota(pairs.begin(), pairs.end(), 0);
+        auto rank = [&](int p) {
+            int a = network->links[2 * p]->getSrc()->getId(), b = network->links[2 * p]->getDest()->getId();
+            return std::make_pair(std::min(a, b), std::max(a, b));
+        };
+        std::stable_sort(pairs.begin(), pairs.end(), [&](int p, int q) { return rank(p) < rank(q); });
+
+        vec<ptr<Link>> sorted;
+        sorted.reserve(network->links.size());
+        for (int p : pairs) sorted.push_back(network->links[2 * p]), sorted.push_back(network->links[2 * p + 1]);
+        network->links = sorted;
+    }
+
+    for (auto &s : network->stations) s->track(network->state); // after renumbering, so the terms use the final ids
+    for (auto &l : network->links) l->track(network->state);
+
+    stations.clear();
+    links.clear();
+    return network;
+}
@@ -0,0 +1,111 @@
+#ifndef RAILWAYS_NETWORKBUILDER_H
+#define RAILWAYS_NETWORKBUILDER_H
+
+#include "Network.h"
+
+/**
+ * @brief Station Order
+ *
+ * @details Order in which NetworkBuilder numbers the stations
+ */
+enum StationOrder {
+    INPUT_ORDER,    ///< Order in which the stations were added
+    BFS_ORDER,      ///< Breadth-first order, so neighbours get close ids
+    RCM_ORDER,      ///< Reverse Cuthill-McKee order, which keeps the ids of linked stations closest
+    DISTRICT_ORDER  ///< Grouped by district, in breadth-first order inside each district
+};
+
+/**
+ * @brief Network Builder class
+ *
+ * @details Collects every station and link of a network and builds it at once.
+ * Duplicates are handled as in Network::addStation and Network::addLink (the first station with each id, and the first
+ * link between each pair of stations in either direction, are kept), but they are found with hash sets instead of
+ * scanning the stations and adjacency lists for every insertion.
+ */
+class NetworkBuilder {
+private:
+
+    /**
+     * @brief Stations added, in order
+     */
+    vec<ptr<Station>> stations;
+
+    /**
+     * @brief Links added, in order
+     */
+    vec<LinkRecord> links;
+
+    /**
+     * @brief Order of the stations in the network built
+     */
+    StationOrder order = INPUT_ORDER;
+
+    /**
+     * @brief Permutation
+     *
+     * @param network Network built, with the stations in input order
+     *
+     * @return Position in the input of the station that gets each new id
+     *
+     * @details This function has Complexity O(V + E), or O(V log V + E log E) for RCM and district order.
+     */
+    vec<int> permutation(const ptr<Network> &network) const;
+
+public:
+
+    /**
+     * @brief Add Station
+     *
+     * @param station Station to be added
+     *
+     * @details This function has Complexity O(1).
+     */
+    void addStation(const ptr<Station> &station);
+
+    /**
+     * @brief Add Link
+     *
+     * @param st1 Source station
+     * @param st2 Destination station
+     * @param capacity Link capacity
+     * @param service Link service
+     *
+     * @details This function has Complexity O(1).
+     */
+    void addLink(const ptr<Station> &st1, const ptr<Station> &st2, int capacity, int service);
+
+    /**
+     * @brief Add Links
+     *
+     * @param records Links to be added, in order
+     *
+     * @details This function has Complexity O(n) where n is the number of records.
+     */
+    void addLinks(const vec<LinkRecord> &records);
+
+    /**
+     * @brief Set Order
+     *
+     * @param order Order of the stations in the network built
+     *
+     * @details With any order other than INPUT_ORDER, the stations are renumbered 0..V-1 in that order and the links
+     * are sorted by their stations, so that linked stations are close together in the snapshots taken by the flow
+     * kernels. The previous ids are kept in Network::getInputId.
+     */
+    void setOrder(StationOrder order);
+
+    /**
+     * @brief Build
+     *
+     * @return Network with every station and link added, without duplicates
+     *
+     * @details Gives the same network as adding every station and then every link to an empty network one at a time,
+     * then applies the station order. The builder is left empty. This function has Complexity O(V + E) where V is the number of stations and E is
+     * the number of links.
+     */
+    ptr<Network> build();
+};
+
+
+#endif //RAILWAYS_NETWORKBUILDER_H
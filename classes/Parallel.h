@@ -0,0 +1,59 @@
+#ifndef RAILWAYS_PARALLEL_H
+#define RAILWAYS_PARALLEL_H
+
+#include <bits/stdc++.h>
+
+/**
+ * @brief Worker Count
+ *
+ * @return Number of worker threads to use
+ *
+ * @details Returns the number of hardware threads, or 1 if it cannot be determined.
+ */
+inline unsigned int workerCount() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * @brief Inside Parallel For
+ *
+ * @details Whether the calling thread is running a task of parallelFor
+ */
+inline thread_local bool insideParallelFor = false;
+
+/**
+ * @brief Parallel For
+ *
+ * @param count Number of tasks
+ * @param fn Function called as fn(task, worker) for every task in [0, count)
+ *
+ * @details Runs the tasks over workerCount() threads. Tasks are handed out one at a time through an atomic counter,
+ * so uneven task costs are balanced between the workers. The worker index is in [0, workerCount()) and can be used
+ * to pick per-thread scratch memory. A parallelFor called from inside a task runs on the calling thread, so nested
+ * loops do not multiply the threads.
+ *
+ * @warning fn must be safe to call concurrently from different threads.
+ */
+template<typename F>
+void parallelFor(int count, F fn) {
+    int workers = insideParallelFor ? 1 : (int) std::min<unsigned int>(workerCount(), std::max(count, 1));
+    std::atomic<int> next(0);
+
+    auto run = [&](int worker) {
+        bool outer = insideParallelFor;
+        insideParallelFor = true;
+        for (int i = next++; i < count; i = next++) fn(i, worker);
+        insideParallelFor = outer;
+    };
+
+    if (workers == 1) { run(0); return; }
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; w++) threads.emplace_back(run, w);
+    run(0);
+    for (auto &t : threads) t.join();
+}
+
+
+#endif //RAILWAYS_PARALLEL_H
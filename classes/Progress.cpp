@@ -0,0 +1,27 @@
+#include "Progress.h"
+
+Progress::Progress(Callback callback, std::chrono::milliseconds interval) : callback(std::move(callback)), interval(interval) {}
+
+void Progress::cancel() {
+    cancelled = true;
+}
+
+void Progress::setDeadline(std::chrono::milliseconds timeout) {
+    deadline = std::chrono::steady_clock::now() + timeout;
+}
+
+bool Progress::isCancelled() {
+    if (cancelled.load(std::memory_order_relaxed)) return true;
+    if (deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline) cancelled = true;
+    return cancelled;
+}
+
+void Progress::report(long long done, long long total, long long best) {
+    if (!callback) return;
+    long long now = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (done < total && now < due.load(std::memory_order_relaxed)) return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    due = now + interval.count();
+    callback(done, total, best);
+}
@@ -0,0 +1,102 @@
+#ifndef RAILWAYS_PROGRESS_H
+#define RAILWAYS_PROGRESS_H
+
+#include <bits/stdc++.h>
+
+/**
+ * @brief Progress class
+ *
+ * @details Progress of a long analysis, shared between the threads running it and the caller watching it.
+ * The analysis reports how far it got through report, which calls the callback at most once per interval, and checks
+ * isCancelled between steps. A cancelled analysis stops early and returns the best results found so far.
+ * The caller cancels the analysis from any thread, or gives it a deadline.
+ */
+class Progress {
+public:
+
+    /**
+     * @brief Callback
+     *
+     * @details Called with the steps done, the total steps and the best value found so far
+     */
+    using Callback = std::function<void(long long done, long long total, long long best)>;
+
+private:
+
+    /**
+     * @brief Called on every report due
+     */
+    Callback callback;
+
+    /**
+     * @brief Least time between two calls of the callback
+     */
+    std::chrono::steady_clock::duration interval;
+
+    /**
+     * @brief Time after which the analysis is cancelled
+     */
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    /**
+     * @brief Whether the analysis was cancelled
+     */
+    std::atomic<bool> cancelled{false};
+
+    /**
+     * @brief Time the callback is next due, in steady clock ticks
+     */
+    std::atomic<long long> due{0};
+
+    /**
+     * @brief Keeps the callback from running on several threads at once
+     */
+    std::mutex lock;
+
+public:
+
+    /**
+     * @brief Progress Constructor
+     *
+     * @param callback Called with the progress of the analysis (none by default)
+     * @param interval Least time between two calls of the callback
+     */
+    explicit Progress(Callback callback = nullptr, std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+
+    /**
+     * @brief Cancel
+     *
+     * @details Asks the analysis to stop. It can be called from any thread.
+     */
+    void cancel();
+
+    /**
+     * @brief Set Deadline
+     *
+     * @param timeout Time from now after which the analysis is cancelled
+     *
+     * @warning Set it before the analysis starts
+     */
+    void setDeadline(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Is Cancelled
+     *
+     * @return true if the analysis was cancelled or its deadline passed
+     */
+    bool isCancelled();
+
+    /**
+     * @brief Report
+     *
+     * @param done Steps done
+     * @param total Total steps
+     * @param best Best value found so far
+     *
+     * @details Calls the callback if it is due, or if every step is done. It can be called from any thread.
+     */
+    void report(long long done, long long total, long long best);
+};
+
+
+#endif //RAILWAYS_PROGRESS_H
@@ -0,0 +1,69 @@
+#include "ResultCache.h"
+
+size_t ResultCache::KeyHash::operator()(const QueryKey &k) const {
+    size_t h = std::hash<unsigned long long>()(k.state);
+    for (unsigned long long x : {(unsigned long long) k.kind, (unsigned long long) k.src, (unsigned long long) k.dest, k.version})
+        h = h * 1099511628211ULL ^ std::hash<unsigned long long>()(x);
+    return h;
+}
+
+ResultCache::ResultCache(size_t _capacity) : capacity(_capacity) {}
+
+bool ResultCache::get(const QueryKey &key, unsigned int &value) {
+    long long result;
+    if (!get(key, result)) return false;
+    value = (unsigned int) result;
+    return true;
+}
+
+bool ResultCache::get(const QueryKey &key, long long &value) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = index.find(key);
+    if (it == index.end()) { misses++; return false; }
+
+    entries.splice(entries.begin(), entries, it->second);
+    value = it->second->second;
+    hits++;
+    return true;
+}
+
+void ResultCache::put(const QueryKey &key, long long value) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (capacity == 0) return;
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        it->second->second = value;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    if (entries.size() == capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(key, value);
+    index[key] = entries.begin();
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    entries.clear();
+    index.clear();
+    hits = misses = 0;
+}
+
+size_t ResultCache::size() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+unsigned long long ResultCache::getHits() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return hits;
+}
+
+unsigned long long ResultCache::getMisses() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return misses;
+}
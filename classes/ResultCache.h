@@ -0,0 +1,165 @@
+#ifndef RAILWAYS_RESULTCACHE_H
+#define RAILWAYS_RESULTCACHE_H
+
+#include <bits/stdc++.h>
+
+/**
+ * @brief Query Kind
+ *
+ * @details Kind of a cached query
+ */
+enum QueryKind {
+    MAX_FLOW_QUERY,
+    MAX_COST_QUERY,
+    MAX_TRAINS_QUERY,
+    DISTRICT_FLOW_QUERY,
+    MUNICIPALITY_FLOW_QUERY
+};
+
+/**
+ * @brief Query Key
+ *
+ * @details Everything a query result depends on
+ */
+struct QueryKey {
+    /**
+     * @brief Kind of query
+     */
+    QueryKind kind;
+
+    /**
+     * @brief Station ids of the endpoints (-1 if unused)
+     */
+    int src, dest;
+
+    /**
+     * @brief Version of the network topology
+     */
+    unsigned long long version;
+
+    /**
+     * @brief Hash of the enabled status, capacities and costs of the stations and links
+     */
+    unsigned long long state;
+
+    bool operator==(const QueryKey &other) const {
+        return kind == other.kind && src == other.src && dest == other.dest && version == other.version && state == other.state;
+    }
+};
+
+/**
+ * @brief Result Cache class
+ *
+ * @details Thread-safe least recently used cache of query results. When full, adding a result evicts the one that
+ * was used least recently.
+ */
+class ResultCache {
+private:
+
+    /**
+     * @brief Hash of a query key
+     */
+    struct KeyHash {
+        size_t operator()(const QueryKey &k) const;
+    };
+
+    /**
+     * @brief Maximum number of results kept
+     */
+    size_t capacity;
+
+    /**
+     * @brief Results, most recently used first
+     */
+    std::list<std::pair<QueryKey, long long>> entries;
+
+    /**
+     * @brief Position of each key in entries
+     */
+    std::unordered_map<QueryKey, std::list<std::pair<QueryKey, long long>>::iterator, KeyHash> index;
+
+    /**
+     * @brief Lookups that found a result, and lookups that did not
+     */
+    unsigned long long hits = 0, misses = 0;
+
+    /**
+     * @brief Lock guarding every member
+     */
+    mutable std::mutex lock;
+
+public:
+
+    /**
+     * @brief Result Cache Constructor
+     *
+     * @param capacity Maximum number of results kept
+     */
+    explicit ResultCache(size_t capacity = 4096);
+
+    /**
+     * @brief Get
+     *
+     * @param key Query key
+     * @param value Set to the result, if it is cached
+     *
+     * @return true if the result is cached
+     *
+     * @details Marks the result as the most recently used. This function has Complexity O(1).
+     */
+    bool get(const QueryKey &key, unsigned int &value);
+
+    /**
+     * @brief Get
+     *
+     * @param key Query key
+     * @param value Set to the result, if it is cached
+     *
+     * @return true if the result is cached
+     *
+     * @details Same as the other get, for results that need 64 bits, such as costs.
+     */
+    bool get(const QueryKey &key, long long &value);
+
+    /**
+     * @brief Put
+     *
+     * @param key Query key
+     * @param value Result of the query
+     *
+     * @details Adds or updates a result, evicting the least recently used one if the cache is full.
+     * This function has Complexity O(1).
+     */
+    void put(const QueryKey &key, long long value);
+
+    /**
+     * @brief Clear
+     *
+     * @details Removes every result and resets the statistics.
+     */
+    void clear();
+
+    /**
+     * @brief Get Size
+     *
+     * @return Number of results cached
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get Hits
+     *
+     * @return Number of lookups that found a result
+     */
+    unsigned long long getHits() const;
+
+    /**
+     * @brief Get Misses
+     *
+     * @return Number of lookups that did not find a result
+     */
+    unsigned long long getMisses() const;
+};
+
+
+#endif //RAILWAYS_RESULTCACHE_H
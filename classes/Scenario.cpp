@@ -0,0 +1,67 @@
+#include "Scenario.h"
+#include "Hash.h"
+
+namespace {
+    /**
+     * @brief Same for a link and its reverse: the ids of its stations, smallest first
+     */
+    unsigned long long pairOf(const ptr<Link> &l) {
+        int a = l->getSrc()->getId(), b = l->getDest()->getId();
+        return (unsigned long long) (uint32_t) std::min(a, b) << 32 | (uint32_t) std::max(a, b);
+    }
+}
+
+Scenario::Scenario(ptr<const Scenario> _base) : base(std::move(_base)) {}
+
+void Scenario::disable(const ptr<Station> &station) {
+    stations.push_back(station);
+}
+
+void Scenario::disable(const ptr<Link> &link) {
+    links.push_back(link);
+}
+
+void Scenario::setCapacity(const ptr<Link> &link, int capacity) {
+    capacities.emplace_back(link, capacity);
+}
+
+const ptr<const Scenario> &Scenario::getBase() const {
+    return base;
+}
+
+const vec<ptr<Station>> &Scenario::getStations() const {
+    return stations;
+}
+
+const vec<ptr<Link>> &Scenario::getLinks() const {
+    return links;
+}
+
+const vec<std::pair<ptr<Link>, int>> &Scenario::getCapacities() const {
+    return capacities;
+}
+
+long long Scenario::maxCapacity() const {
+    long long ans = base ? base->maxCapacity() : 0;
+    for (auto &c : capacities) ans = std::max<long long>(ans, c.second);
+    return ans;
+}
+
+unsigned long long Scenario::hash() const {
+    vec<const Scenario*> chain; // oldest base first
+    for (auto s = this; s; s = s->base.get()) chain.push_back(s);
+    std::reverse(chain.begin(), chain.end());
+
+    std::set<unsigned long long> out; // disabled stations and links, each once
+    std::map<unsigned long long, int> capacity; // final capacity of each link, later changes win
+    for (auto s : chain) {
+        for (auto &st : s->stations) out.insert(mix(mix((uint32_t) st->getId()) + 1));
+        for (auto &l : s->links) out.insert(mix(mix(pairOf(l)) + 2));
+        for (auto &[l, c] : s->capacities) capacity[pairOf(l)] = c;
+    }
+
+    unsigned long long h = 0;
+    for (auto x : out) h += x;
+    for (auto &[l, c] : capacity) h += mix(mix(mix(l) + 3) + (unsigned long long) c * 0x100000001B3ULL);
+    return h;
+}
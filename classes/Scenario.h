@@ -0,0 +1,128 @@
+#ifndef RAILWAYS_SCENARIO_H
+#define RAILWAYS_SCENARIO_H
+
+#include "StationLink.h"
+
+/**
+ * @brief Scenario class
+ *
+ * @details What-if overlay on a network: the stations and links that are out of service and the links with a different
+ * capacity. The network itself is never modified, so any number of scenarios can be evaluated at the same time over a
+ * single FlowGraph snapshot.
+ * A scenario can extend a base scenario, which is shared rather than copied: it only records its own changes on top of
+ * the base. Scenarios are immutable once they are shared, so they should be fully built before being used as a base.
+ */
+class Scenario {
+private:
+
+    /**
+     * @brief Scenario this one extends (nullptr if none)
+     */
+    ptr<const Scenario> base;
+
+    /**
+     * @brief Stations out of service
+     */
+    vec<ptr<Station>> stations;
+
+    /**
+     * @brief Links out of service (both directions)
+     */
+    vec<ptr<Link>> links;
+
+    /**
+     * @brief Links with a different capacity (both directions), and their capacity
+     */
+    vec<std::pair<ptr<Link>, int>> capacities;
+
+public:
+
+    /**
+     * @brief Scenario Constructor
+     *
+     * @details Creates a scenario with no changes
+     */
+    Scenario() = default;
+
+    /**
+     * @brief Scenario Constructor
+     *
+     * @param base Scenario to extend
+     *
+     * @details Creates a scenario with every change of base. This function has Complexity O(1).
+     */
+    explicit Scenario(ptr<const Scenario> base);
+
+    /**
+     * @brief Disable Station
+     *
+     * @param station Station out of service
+     */
+    void disable(const ptr<Station> &station);
+
+    /**
+     * @brief Disable Link
+     *
+     * @param link Link out of service, in both directions
+     */
+    void disable(const ptr<Link> &link);
+
+    /**
+     * @brief Set Capacity
+     *
+     * @param link Link, in both directions
+     * @param capacity New capacity
+     *
+     * @details Later changes win over earlier ones and over the base, but a link out of service stays out of service.
+     */
+    void setCapacity(const ptr<Link> &link, int capacity);
+
+    /**
+     * @brief Get Base
+     *
+     * @return Scenario this one extends (nullptr if none)
+     */
+    const ptr<const Scenario> &getBase() const;
+
+    /**
+     * @brief Get Stations
+     *
+     * @return Stations out of service in this scenario, not counting the base
+     */
+    const vec<ptr<Station>> &getStations() const;
+
+    /**
+     * @brief Get Links
+     *
+     * @return Links out of service in this scenario, not counting the base
+     */
+    const vec<ptr<Link>> &getLinks() const;
+
+    /**
+     * @brief Get Capacities
+     *
+     * @return Capacity changes of this scenario, not counting the base
+     */
+    const vec<std::pair<ptr<Link>, int>> &getCapacities() const;
+
+    /**
+     * @brief Max Capacity
+     *
+     * @return Largest capacity set by this scenario or its base (0 if none)
+     */
+    long long maxCapacity() const;
+
+    /**
+     * @brief Hash
+     *
+     * @return Hash of the network the scenario leaves, including the base
+     *
+     * @details Hashes the final capacity of each changed link, after later changes override earlier ones, and the
+     * stations and links out of service, so scenarios that leave the same network hash the same.
+     * This function has Complexity O(C log(C)) where C is the number of changes.
+     */
+    unsigned long long hash() const;
+};
+
+
+#endif //RAILWAYS_SCENARIO_H
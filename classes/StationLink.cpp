@@ -1,4 +1,5 @@
 #include "StationLink.h"
+#include "Hash.h"
 
 Link::Link(ptr<Station> src, ptr<Station> dest, int capacity, int service) {
     this->src = std::move(src);
@@ -25,10 +26,12 @@ int Link::getService() const {
 
 void Link::setCapacity(int _capacity) {
     Link::capacity = _capacity;
+    updateTerm();
 }
 
 void Link::setService(int _service) {
     Link::service = _service;
+    updateTerm();
 }
 
 Station::Station(int id, std::string name, std::string municipality, std::string township, std::string district) {
@@ -59,6 +62,11 @@ int Station::getId() const {
     return this->id;
 }
 
+void Station::setId(int _id) {
+    this->id = _id;
+    updateTerm();
+}
+
 void Station::addLink(const ptr<Link>& link) {
     this->links.push_back(link);
 }
@@ -87,6 +95,7 @@ bool Station::isEnabled() const {
 
 void Station::setEnabled(bool _enabled) {
     this->enabled = _enabled;
+    updateTerm();
 }
 
 ptr<Link> Station::getPath() {
@@ -115,6 +124,7 @@ bool Link::isEnabled() const {
 
 void Link::setEnabled(bool _enabled) {
     this->enabled = _enabled;
+    updateTerm();
 }
 
 void Link::setReverse(const ptr<Link>& _reverse) {
@@ -134,5 +144,71 @@ void Link::setFlow(int _flow) {
 }
 
 int Link::getCost() const {
-    return this->service == STANDARD ? STANDARD_COST : PENDULAR_COST;
+    return this->cost >= 0 ? this->cost : SERVICE_COST[this->service];
+}
+
+double Link::getDistance() const {
+    return this->distance;
+}
+
+double Link::getEnergy() const {
+    return this->energy;
+}
+
+void Link::setCost(int _cost) {
+    this->cost = _cost;
+    updateTerm();
+}
+
+void Link::setDistance(double _distance) {
+    this->distance = _distance;
+}
+
+void Link::setEnergy(double _energy) {
+    this->energy = _energy;
+}
+
+double Link::getFailureProbability() const {
+    return this->failureProbability;
+}
+
+void Link::setFailureProbability(double _failureProbability) {
+    this->failureProbability = _failureProbability;
+}
+
+double Station::getFailureProbability() const {
+    return this->failureProbability;
+}
+
+void Station::setFailureProbability(double _failureProbability) {
+    this->failureProbability = _failureProbability;
+}
+
+void Link::updateTerm() {
+    if (!state) return;
+    unsigned long long stations = (unsigned long long) src->getId() << 32 | (uint32_t) dest->getId();
+    unsigned long long now = mix(mix(mix(stations) ^ ((unsigned long long) capacity << 8 | service << 1 | enabled)) ^ (unsigned long long) getCost());
+    *state += now - term;
+    term = now;
+}
+
+void Link::track(const ptr<StateHash> &_state) {
+    if (state) *state -= term;
+    state = _state;
+    term = 0;
+    updateTerm();
+}
+
+void Station::updateTerm() {
+    if (!state) return;
+    unsigned long long now = mix(mix((unsigned long long) (uint32_t) id << 1 | enabled));
+    *state += now - term;
+    term = now;
+}
+
+void Station::track(const ptr<StateHash> &_state) {
+    if (state) *state -= term;
+    state = _state;
+    term = 0;
+    updateTerm();
 }
@@ -9,11 +9,33 @@
 
 #define STANDARD 1
 #define PENDULAR 2
-#define STANDARD_COST 2
-#define PENDULAR_COST 4
+
+/**
+ * @brief Cost of a train on a standard link
+ */
+constexpr int STANDARD_COST = 2;
+
+/**
+ * @brief Cost of a train on a pendular link
+ */
+constexpr int PENDULAR_COST = 4;
+
+/**
+ * @brief Cost of a train on a link of each service, indexed by service
+ */
+constexpr int SERVICE_COST[] = {0, STANDARD_COST, PENDULAR_COST};
 
 class Station;
 
+/**
+ * @brief State Hash
+ *
+ * @details Hash of the enabled status, capacities and costs of the stations and links of a network, kept as the sum of
+ * a term per station and link. Each station and link tracked by a network replaces its own term whenever one of its
+ * setters changes them, so the hash is always up to date without scanning the network.
+ */
+using StateHash = std::atomic<unsigned long long>;
+
 /**
  * @brief Link class
  *
@@ -61,6 +83,39 @@ protected:
      */
     ptr<Link> reverse = nullptr; // reverse link
 
+    /**
+     * @brief Link failure probability
+     */
+    double failureProbability = 0;
+
+    /**
+     * @brief Operating cost of a train on the link (-1 for the cost of its service)
+     */
+    int cost = -1;
+
+    /**
+     * @brief Link distance and energy used by a train (0 if unknown)
+     */
+    double distance = 0, energy = 0;
+
+    /**
+     * @brief State hash of the network the link belongs to (nullptr if none)
+     */
+    ptr<StateHash> state = nullptr;
+
+    /**
+     * @brief Term of the link in the state hash
+     */
+    unsigned long long term = 0;
+
+    /**
+     * @brief Update Term
+     *
+     * @details Replaces the term of the link in the state hash with one for its current stations, capacity, service,
+     * enabled status and cost. This function has Complexity O(1).
+     */
+    void updateTerm();
+
 public:
 
     /**
@@ -114,10 +169,46 @@ public:
     /**
      * @brief Get Link Cost
      *
-     * @details This function returns the cost of the link.
+     * @details This function returns the operating cost of a train on the link: its own cost if it has one, and the
+     * cost of its service otherwise.
      */
     int getCost() const;
 
+    /**
+     * @brief Get Link Distance
+     *
+     * @details This function returns the distance of the link (0 if unknown).
+     */
+    double getDistance() const;
+
+    /**
+     * @brief Get Link Energy
+     *
+     * @details This function returns the energy used by a train on the link (0 if unknown).
+     */
+    double getEnergy() const;
+
+    /**
+     * @brief Set Link Cost
+     *
+     * @details This function sets the operating cost of a train on the link (-1 for the cost of its service).
+     */
+    void setCost(int cost);
+
+    /**
+     * @brief Set Link Distance
+     *
+     * @details This function sets the distance of the link.
+     */
+    void setDistance(double distance);
+
+    /**
+     * @brief Set Link Energy
+     *
+     * @details This function sets the energy used by a train on the link.
+     */
+    void setEnergy(double energy);
+
     /**
      * @brief Get Link Enabled status
      *
@@ -166,6 +257,30 @@ public:
      * @details This function sets the reverse link of the link.
      */
     void setReverse(const ptr<Link>& reverse);
+
+    /**
+     * @brief Get Link Failure Probability
+     *
+     * @details This function returns the probability of the link failing.
+     */
+    double getFailureProbability() const;
+
+    /**
+     * @brief Set Link Failure Probability
+     *
+     * @details This function sets the probability of the link failing.
+     */
+    void setFailureProbability(double failureProbability);
+
+    /**
+     * @brief Track
+     *
+     * @param state State hash of the network the link is added to
+     *
+     * @details Adds the term of the link to the state hash (moving it from the one it was in, if any), which its setters
+     * then keep up to date.
+     */
+    void track(const ptr<StateHash> &state);
 };
 
 /**
@@ -207,11 +322,34 @@ protected:
      */
     int cost = 0;
 
+    /**
+     * @brief Station failure probability
+     */
+    double failureProbability = 0;
+
     /**
      * @brief List of Station Links
      */
     std::list<ptr<Link>> links;
 
+    /**
+     * @brief State hash of the network the station belongs to (nullptr if none)
+     */
+    ptr<StateHash> state = nullptr;
+
+    /**
+     * @brief Term of the station in the state hash
+     */
+    unsigned long long term = 0;
+
+    /**
+     * @brief Update Term
+     *
+     * @details Replaces the term of the station in the state hash with one for its current id and enabled status.
+     * This function has Complexity O(1).
+     */
+    void updateTerm();
+
 public:
     /**
      * @brief Station constructor
@@ -236,6 +374,15 @@ public:
      */
     int getId() const;
 
+    /**
+     * @brief Set Id method
+     *
+     * @param id Station id
+     *
+     * @details This method sets the id of the station
+     */
+    void setId(int id);
+
     /**
      * @brief Add Link method
      *
@@ -379,6 +526,66 @@ public:
      * @details This method removes the link
      */
     void removeLink(const ptr<Link>& link);
+
+    /**
+     * @brief Get Failure Probability method
+     *
+     * @return Probability of the station failing
+     *
+     * @details This method gets the probability of the station failing
+     */
+    double getFailureProbability() const;
+
+    /**
+     * @brief Set Failure Probability method
+     *
+     * @param failureProbability Probability of the station failing
+     *
+     * @details This method sets the probability of the station failing
+     */
+    void setFailureProbability(double failureProbability);
+
+    /**
+     * @brief Track
+     *
+     * @param state State hash of the network the station is added to
+     *
+     * @details Adds the term of the station to the state hash (moving it from the one it was in, if any), which its
+     * setters then keep up to date.
+     */
+    void track(const ptr<StateHash> &state);
+};
+
+/**
+ * @brief Link Record
+ *
+ * @details A link waiting to be added to a network, such as a row of a network file
+ */
+struct LinkRecord {
+    /**
+     * @brief Stations at both ends of the link
+     */
+    ptr<Station> src, dest;
+
+    /**
+     * @brief Link capacity
+     */
+    int capacity;
+
+    /**
+     * @brief Link service (STANDARD or PENDULAR)
+     */
+    int service;
+
+    /**
+     * @brief Operating cost of a train (-1 for the cost of the service)
+     */
+    int cost = -1;
+
+    /**
+     * @brief Distance and energy used by a train (0 if unknown)
+     */
+    double distance = 0, energy = 0;
 };
 
 
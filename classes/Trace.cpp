@@ -0,0 +1,74 @@
+#include "Trace.h"
+
+namespace {
+    /**
+     * @brief Events recorded by one thread
+     */
+    struct Buffer {
+        int tid;
+        std::vector<Trace::Event> events;
+    };
+
+    std::atomic<bool> enabled(false);
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::mutex lock;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    std::atomic<int> generation(0);
+
+    Buffer &buffer() {
+        thread_local std::shared_ptr<Buffer> own;
+        thread_local int ownGeneration = -1;
+
+        if (!own || ownGeneration != generation) {
+            std::lock_guard<std::mutex> guard(lock);
+            own = std::make_shared<Buffer>();
+            own->tid = (int) buffers.size() + 1;
+            buffers.push_back(own);
+            ownGeneration = generation;
+        }
+        return *own;
+    }
+}
+
+void Trace::start() {
+    std::lock_guard<std::mutex> guard(lock);
+    buffers.clear();
+    generation++;
+    origin = std::chrono::steady_clock::now();
+    enabled = true;
+}
+
+void Trace::stop() {
+    enabled = false;
+}
+
+bool Trace::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+long long Trace::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::record(const char *name, long long begin, long long end) {
+    buffer().events.push_back({name, begin, end});
+}
+
+bool Trace::write(const std::string &path) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    for (auto &b : buffers) {
+        for (auto &e : b->events) {
+            file << (first ? "\n" : ",\n");
+            file << "{\"name\":\"" << e.name << "\",\"cat\":\"railways\",\"ph\":\"X\",\"ts\":" << e.begin
+                 << ",\"dur\":" << e.end - e.begin << ",\"pid\":1,\"tid\":" << b->tid << "}";
+            first = false;
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return (bool) file;
+}
@@ -0,0 +1,126 @@
+#ifndef RAILWAYS_TRACE_H
+#define RAILWAYS_TRACE_H
+
+#include <bits/stdc++.h>
+
+/**
+ * @brief Trace class
+ *
+ * @details Optional profiling of the phases of each operation (loading, super source, each search, path updates,
+ * teardown). Phases are recorded with their start time, duration and thread, and written as Chrome trace-event JSON,
+ * which can be opened in chrome://tracing or Perfetto.
+ * Each thread records into its own buffer, so tracing adds no locking to the flow kernels. When tracing is off,
+ * a phase costs a single check of an atomic flag.
+ */
+class Trace {
+public:
+
+    /**
+     * @brief Event
+     *
+     * @details A phase of an operation
+     */
+    struct Event {
+        /**
+         * @brief Phase name
+         */
+        const char *name;
+
+        /**
+         * @brief Start and end, in microseconds since tracing started
+         */
+        long long begin, end;
+    };
+
+    /**
+     * @brief Start
+     *
+     * @details Clears any previous events and starts recording.
+     */
+    static void start();
+
+    /**
+     * @brief Stop
+     *
+     * @details Stops recording. Recorded events are kept until the next start.
+     */
+    static void stop();
+
+    /**
+     * @brief Is Enabled
+     *
+     * @return true if events are being recorded
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Now
+     *
+     * @return Microseconds since tracing started
+     */
+    static long long now();
+
+    /**
+     * @brief Record
+     *
+     * @param name Phase name (must outlive the trace, usually a string literal)
+     * @param begin Start of the phase
+     * @param end End of the phase
+     *
+     * @details Records a phase in the buffer of the calling thread.
+     */
+    static void record(const char *name, long long begin, long long end);
+
+    /**
+     * @brief Write
+     *
+     * @param path File to write
+     *
+     * @return true if the file was written
+     *
+     * @details Writes every recorded event as Chrome trace-event JSON.
+     *
+     * @warning No thread should be recording while the trace is written.
+     */
+    static bool write(const std::string &path);
+};
+
+/**
+ * @brief Trace Scope class
+ *
+ * @details Records the phase from its construction to the end of the enclosing scope, if tracing is enabled.
+ */
+class TraceScope {
+private:
+
+    /**
+     * @brief Phase name
+     */
+    const char *name;
+
+    /**
+     * @brief Start of the phase (-1 if tracing was off)
+     */
+    long long begin;
+
+public:
+
+    /**
+     * @brief Trace Scope Constructor
+     *
+     * @param name Phase name (must outlive the trace, usually a string literal)
+     */
+    explicit TraceScope(const char *name) : name(name), begin(Trace::isEnabled() ? Trace::now() : -1) {}
+
+    /**
+     * @brief Trace Scope Destructor
+     *
+     * @details Records the phase.
+     */
+    ~TraceScope() {
+        if (begin != -1) Trace::record(name, begin, Trace::now());
+    }
+};
+
+
+#endif //RAILWAYS_TRACE_H
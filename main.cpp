@@ -1,4 +1,7 @@
 #include "classes/Network.h"
+#include "classes/CsvReader.h"
+#include "classes/NetworkBuilder.h"
+#include "classes/FlowMatrix.h"
 
 /**
  * @brief Network
@@ -15,11 +18,18 @@ auto network = make<Network>();
 std::unordered_map<std::string, ptr<Station>> stations;
 
 /**
- * @brief Municipality Capacities
+ * @brief Dataset
  *
- * @details Map of municipality capacities
+ * @details Stations and network files the network was read from
  */
-std::unordered_map<std::string, int> municipality_capacities;
+std::string stations_file, links_file;
+
+/**
+ * @brief Flow Matrix
+ *
+ * @details Max flow of every pair of stations of the network, loaded or computed when the network is read
+ */
+FlowMatrix matrix;
 
 // Start Screen
 void starting_screen();
@@ -34,32 +44,54 @@ void station_capacity(); // Menu Button 1.1
 void high_traffic_routes(); // Menu Button 1.2
 void budget_allocation(); // Menu Button 1.3
 void station_arrival_capacity(); // Menu Button 1.4
+void arrival_capacity_ranking(); // Menu Button 1.5
+void capacity_investment(); // Menu Button 1.6
+void station_load(); // Menu Button 1.7
 
 // Menu Button 2
 void service_allocation();
 
 void optimal_route(); // Menu Button 2.1
+void budget_trains(); // Menu Button 2.2
 
 // Menu Button 3
 void failure_forecasting();
 
 void reduced_connectivity(); // Menu Button 3.1
 void segment_failure_report(); // Menu Button 3.2
+void reliability_estimation(); // Menu Button 3.3
+void double_failure_report(); // Menu Button 3.4
+void station_failure_report(); // Menu Button 3.5
+void weakest_cut_report(); // Menu Button 3.6
 
 // Support Functions
 void clear_screen();
 void wait();
 bool is_number(const std::string& s);
 bool is_linked(const std::string& s1, const std::string& s2);
+ptr<Station> ask_station(const std::string& prompt);
+int ask_number(const std::string& prompt);
+void ask_station_pair(ptr<Station>& st1, ptr<Station>& st2);
+void ask_flow_or_arrival(const std::string& action, ptr<Station>& st1, ptr<Station>& st2);
+StationOrder station_order();
+void load_graph(bool partial);
+bool prepare_flow_matrix(bool *computed = nullptr);
+const FlowMatrix& flow_matrix();
+ptr<Station> station_by_input_id(int id);
+ptr<Progress> progress_line(const std::string& what);
+ptr<Checkpoint> checkpoint_file();
 
 /**
  * @brief Reads the Stations
  *
- * @details Reads the stations from the stations.csv file and adds them to the network
+ * @param builder Builder of the network
+ *
+ * @details Reads the stations from the stations.csv file and adds them to the network builder
  *
  * @warning The file must be in the data folder
  */
-void readStations() {
+void readStations(NetworkBuilder &builder) {
+    TraceScope scope("load stations");
     std::ifstream file("../data/stations.csv");
     std::string line;
     std::getline(file, line);
@@ -76,14 +108,14 @@ void readStations() {
         std::getline(ss, township, ',');
         std::getline(ss, line);     // ignore this
         auto station = make<Station>(id++, name, municipality, township, district);
-        network->addStation(station);
+        builder.addStation(station);
         stations[name] = station;
-        municipality_capacities[municipality] = 0;
     }
     file.close();
 }
 
-void readPartialStations(){
+void readPartialStations(NetworkBuilder &builder){
+    TraceScope scope("load stations");
     std::ifstream file("../data/partial_stations.csv");
     std::string line;
     std::getline(file, line);
@@ -100,9 +132,8 @@ void readPartialStations(){
         std::getline(ss, township, ',');
         std::getline(ss, line);     // ignore this
         auto station = make<Station>(id++, name, municipality, township, district);
-        network->addStation(station);
+        builder.addStation(station);
         stations[name] = station;
-        municipality_capacities[municipality] = 0;
     }
     file.close();
 }
@@ -111,78 +142,53 @@ void readPartialStations(){
 /**
  * @brief Reads the Links
  *
- * @details Reads the links from the network.csv file and adds them to the network
+ * @param builder Builder of the network
+ * @param path Network file
+ *
+ * @details Reads the links from a network file, parsing it over several threads, and adds them to the network builder
+ * in file order
  *
  * @warning The file must be in the data folder
  */
-void readLinks() {
-    std::ifstream file("../data/network.csv");
-    std::string line;
-    std::getline(file, line);
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string st1, st2, service;
-        int capacity;
-        std::getline(ss, st1, ',');
-        std::transform(st1.begin(), st1.end(), st1.begin(), ::toupper);
-        std::getline(ss, st2, ',');
-        std::transform(st2.begin(), st2.end(), st2.begin(), ::toupper);
-        ss >> capacity; ss.ignore();
-        ss >> service;
-        if (service[service.size()-1] == '\r') service = service.substr(0, service.size() - 1);
-        int srvc = service == "STANDARD" ? STANDARD : PENDULAR;
-        network->addLink(stations.at(st1), stations.at(st2), capacity, srvc);
-        std::string municipality1 = stations.at(st1)->getMunicipality();
-        std::string municipality2 = stations.at(st2)->getMunicipality();
-        if (municipality1 != municipality2) {
-            municipality_capacities[municipality1] += capacity;
-            municipality_capacities[municipality2] += capacity;
-        }
-        else {
-            municipality_capacities[municipality1] += capacity;
-        }
-    }
-    file.close();
-}
-
-void readPartialLinks() {
-    std::ifstream file("../data/partial_network.csv");
-    std::string line;
-    std::getline(file, line);
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string st1, st2, service;
-        int capacity;
-        std::getline(ss, st1, ',');
-        std::transform(st1.begin(), st1.end(), st1.begin(), ::toupper);
-        std::getline(ss, st2, ',');
-        std::transform(st2.begin(), st2.end(), st2.begin(), ::toupper);
-        ss >> capacity; ss.ignore();
-        ss >> service;
-        if (service[service.size()-1] == '\r') service = service.substr(0, service.size() - 1);
-        int srvc = service == "STANDARD" ? STANDARD : PENDULAR;
-        network->addLink(stations.at(st1), stations.at(st2), capacity, srvc);
-        std::string municipality1 = stations.at(st1)->getMunicipality();
-        std::string municipality2 = stations.at(st2)->getMunicipality();
-        if (municipality1 != municipality2) {
-            municipality_capacities[municipality1] += capacity;
-            municipality_capacities[municipality2] += capacity;
-        }
-        else {
-            municipality_capacities[municipality1] += capacity;
-        }
-    }
-    file.close();
+void readLinks(NetworkBuilder &builder, const std::string &path) {
+    TraceScope scope("load links");
+    vec<LinkRecord> records;
+    CsvReader::readLinks(path, stations, records);
+    builder.addLinks(records);
 }
 
 /**
  * @brief Main function
  *
- * @details Reads the stations and links from the files and runs the menu
+ * @details Reads the stations and links from the files and runs the menu.
+ * If the RAILWAYS_TRACE environment variable is set, the phases of every operation are traced and written to the file
+ * it names, as Chrome trace-event JSON, on exit. The RAILWAYS_ORDER environment variable (bfs, rcm or district)
+ * renumbers the stations when the network is built, for better memory locality on large networks.
+ * The max flow of every pair of stations is kept in a .flows file next to the network file, and computed again when
+ * the CSV files change. Run with --precompute to compute the .flows files of both railway systems and exit, so that no
+ * interactive session has to wait for them.
+ *
+ * @param argc Number of arguments
+ * @param argv Arguments
  *
- * @return 0
+ * @return 0, or 1 if a .flows file could not be written
  */
-int main() {
+int main(int argc, char **argv) {
+    const char *trace = std::getenv("RAILWAYS_TRACE");
+    if (trace) Trace::start();
+
+    if (argc > 1 && std::string(argv[1]) == "--precompute") {
+        bool saved = true;
+        for (bool partial : {false, true}) {
+            bool computed = false;
+            load_graph(partial);
+            saved = prepare_flow_matrix(&computed) && saved;
+            std::cout << "  > " << links_file << ": " << (computed ? "computed" : "up to date") << std::endl;
+        }
+        if (trace) Trace::write(trace);
+        return saved ? 0 : 1;
+    }
+
     system("Color 0C");
     std::string option;
     starting_screen();
@@ -243,6 +249,8 @@ int main() {
         }
     } while(option != "0");
 
+    if (trace) Trace::write(trace);
+
     return 0;
 }
 
@@ -327,14 +335,10 @@ void specify_graph(){
         std::cout << "  > ";
         std::getline(std::cin >> std::ws, option);
 
-        if(option == "1"){
-            readStations();
-            readLinks();
-            break;
-        }
-        else if(option == "2"){
-            readPartialStations();
-            readPartialLinks();
+        if(option == "1" || option == "2"){
+            load_graph(option == "2");
+            std::cout << "  > Loading the max flow of every pair of stations..." << std::endl;
+            prepare_flow_matrix();
             break;
         }
         else{
@@ -363,6 +367,9 @@ void train_analysis(){
      * [2] High Traffic Routes - This button determines, from all pairs of stations, which ones require the most amount of trains when taking full advantage of the existing network capacity.
      * [3] Budget Allocation - This button indicates where management should assign larger budgets for the purchasing and maintenance of trains. The implementation should be able to report the top-k municipalities and districts, regarding their transportation needs.
      * [4] Station Arrival Capacity - This button reports the maximum number of trains that can simultaneously arrive at a given station, taking into consideration the entire railway grid.
+     * [5] Arrival Capacity Ranking - This button ranks every station by the maximum number of trains that can simultaneously arrive at it, taking into consideration the entire railway grid.
+     * [6] Capacity Investment - This button indicates which segments should get extra capacity, within a budget of capacity units, to increase the most the maximum number of trains between two stations or arriving at a station.
+     * [7] Station Load - This button ranks every station by the number of trains that go through it when every pair of stations (or a random sample of pairs) runs its maximum number of trains.
      *
      * [0] Go Back - This button returns to the main menu.
      *
@@ -387,13 +394,13 @@ void train_analysis(){
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||    [1] Station Capacity                                                   ||" << std::endl;
         std::cout << "||    [2] High Traffic Routes                                                ||" << std::endl;
         std::cout << "||    [3] Budget Allocation                                                  ||" << std::endl;
         std::cout << "||    [4] Station Arrival Capacity                                           ||" << std::endl;
+        std::cout << "||    [5] Arrival Capacity Ranking                                           ||" << std::endl;
+        std::cout << "||    [6] Capacity Investment                                                ||" << std::endl;
+        std::cout << "||    [7] Station Load                                                       ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                [0] Back   ||" << std::endl;
         std::cout << "\\\\                                                                           //" << std::endl;
@@ -417,6 +424,15 @@ void train_analysis(){
         else if (option == "4") {
             station_arrival_capacity();
         }
+        else if (option == "5") {
+            arrival_capacity_ranking();
+        }
+        else if (option == "6") {
+            capacity_investment();
+        }
+        else if (option == "7") {
+            station_load();
+        }
         else {
             clear_screen();
             std::cout << "  > Invalid Option!" << std::endl;
@@ -494,7 +510,8 @@ void station_capacity() {
     std::cout << "\\\\                                                                           //" << std::endl;
     std::cout << "  ===========================================================================  " << std::endl;
     std::cout << std::endl;
-    std::cout << "  > Max flow between " << st1->getName() << " and " << st2->getName() << ": " << network->maxFlow(st1, st2) << std::endl;
+    int flow = flow_matrix().get(network->getInputId(st1->getId()), network->getInputId(st2->getId()));
+    std::cout << "  > Max flow between " << st1->getName() << " and " << st2->getName() << ": " << flow << std::endl;
     std::cout << std::endl;
     std::cout << "  > Press Enter to Continue..." << std::endl;
     wait();
@@ -504,8 +521,8 @@ void station_capacity() {
 // Button 2 in the Train Analysis Menu
 void high_traffic_routes() {
 
-    vec<std::pair<ptr<Station>, ptr<Station>>> pairs;
-
+    vec<std::pair<int, int>> pairs;
+    int max_flow = flow_matrix().maxPairs(pairs);
 
     clear_screen();
     std::cout << "  ===========================================================================  " << std::endl;
@@ -516,11 +533,11 @@ void high_traffic_routes() {
     std::cout << "  ===========================================================================  " << std::endl;
     std::cout << std::endl;
 
-    std::cout << "                           > Max network flow: " << network->getMaxFlowNetwork(pairs) << " <" << std::endl;
+    std::cout << "                           > Max network flow: " << max_flow << " <" << std::endl;
     std::cout << std::endl;
 
     for (const auto& pair : pairs) {
-        std::cout << "  > " << pair.first->getName() << " -> " << pair.second->getName() << std::endl;
+        std::cout << "  > " << station_by_input_id(pair.first)->getName() << " -> " << station_by_input_id(pair.second)->getName() << std::endl;
     }
 
     std::cout << std::endl;
@@ -532,28 +549,72 @@ void high_traffic_routes() {
 // Button 3 in the Train Analysis Menu
 void budget_allocation() {
 
-    std::priority_queue<std::pair<int, std::string>> pq;
-    for (const auto &pair: municipality_capacities) pq.emplace(pair.second, pair.first);
+    std::string option;
+    int k;
+    bool by_district;
+    vec<std::pair<int, std::string>> ranking; // {Max flow, Region}
 
     clear_screen();
     std::cout << "  ===========================================================================  " << std::endl;
     std::cout << "//                                                                           \\\\" << std::endl;
     std::cout << "||                         --- Budget Allocation ---                         ||" << std::endl;
-    std::cout << "||                  (Municipalities with the most capacity)                  ||" << std::endl;
+    std::cout << "||                (Districts and Municipalities with most flow)              ||" << std::endl;
     std::cout << "\\\\                                                                           //" << std::endl;
     std::cout << "  ===========================================================================  " << std::endl;
     std::cout << std::endl;
 
-    int random = rand() % (10 - 3 + 1) + 3;
+    std::cout << "  > Rank [1] Districts or [2] Municipalities: ";
+    std::getline(std::cin >> std::ws, option);
+    std::cout << std::endl;
+
+    while (option != "1" && option != "2") {
+        clear_screen();
+        std::cout << "  > Invalid option!" << std::endl;
+        std::cout << "  > Press Enter to Continue..." << std::endl;
+        wait();
+
+        clear_screen();
+        std::cout << "  > Please enter [1] for Districts or [2] for Municipalities: ";
+        std::getline(std::cin >> std::ws, option);
+        std::cout << std::endl;
+    }
+
+    by_district = option == "1";
+
+    std::cout << "  > Number of regions to be reported: ";
+    std::getline(std::cin >> std::ws, option);
+    std::cout << std::endl;
+
+    while (!is_number(option)) {
+        clear_screen();
+        std::cout << "  > Invalid option!" << std::endl;
+        std::cout << "  > Press Enter to Continue..." << std::endl;
+        wait();
+
+        clear_screen();
+        std::cout << "  > Please enter the number of regions to be reported: ";
+        std::getline(std::cin >> std::ws, option);
+        std::cout << std::endl;
+    }
+
+    k = std::stoi(option);
+
+    network->regionCapacityRanking(by_district, ranking);
 
-    std::cout << "                > Top "<< random <<" municipalities with the most capacity <" << std::endl;
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                         --- Budget Allocation ---                         ||" << std::endl;
+    std::cout << "||                (Districts and Municipalities with most flow)              ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "                > Top " << k << (by_district ? " districts" : " municipalities") << " with the most flow <" << std::endl;
     std::cout << std::endl;
 
-    int n;
-    for (n = 1 ; n <= random && n < municipality_capacities.size(); n++) {
-        auto pair = pq.top();
-        pq.pop();
-        std::cout << "  > " << n << " - " << pair.second << " -> " << pair.first << std::endl;
+    for (int n = 1; n <= k && n <= (int) ranking.size(); n++) {
+        std::cout << "  > " << n << " - " << ranking[n - 1].second << " -> " << ranking[n - 1].first << std::endl;
     }
 
     std::cout << std::endl;
@@ -615,6 +676,120 @@ void station_arrival_capacity() {
 
 }
 
+// Button 5 in the Train Analysis Menu
+void arrival_capacity_ranking() {
+
+    vec<std::pair<int, int>> ranking; // {Max trains, Id}
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                      --- Arrival Capacity Ranking ---                     ||" << std::endl;
+    std::cout << "||                         (Max Trains of Every Station)                     ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    network->arrivalCapacityRanking(ranking);
+
+    int n = 1;
+    for (auto &p : ranking) {
+        std::cout << "  > " << n++ << " - " << network->getStation(p.second)->getName() << " -> " << p.first << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+
+}
+
+// Button 7 in the Train Analysis Menu
+void station_load() {
+
+    vec<std::pair<long long, int>> load; // {Trains through, Id}
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                            --- Station Load ---                           ||" << std::endl;
+    std::cout << "||                   (Trains Going Through Every Station)                    ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    int samples = ask_number("Number of station pairs to sample (0 for every pair)");
+    int seed = samples == 0 ? 0 : ask_number("Random seed");
+
+    auto progress = progress_line(samples == 0 ? "Source stations evaluated" : "Pairs evaluated");
+    network->stationLoad(samples, seed, load, progress.get());
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                            --- Station Load ---                           ||" << std::endl;
+    std::cout << "||                   (Trains Going Through Every Station)                    ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    int n = 1;
+    for (auto &p : load) {
+        if (p.first == 0) break;
+        std::cout << "  > " << n++ << " - " << network->getStation(p.second)->getName() << " -> " << p.first << std::endl;
+    }
+    if (n == 1) std::cout << "  > No trains go through any station" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
+// Button 6 in the Train Analysis Menu
+void capacity_investment() {
+
+    ptr<Station> st1, st2;
+    vec<std::pair<int, ptr<Link>>> upgrades; // {Extra capacity, Link}
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Capacity Investment ---                        ||" << std::endl;
+    std::cout << "||                     (Segments to Upgrade Within Budget)                   ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    ask_flow_or_arrival("Increase", st1, st2);
+
+    int budget = ask_number("Extra capacity units available");
+
+    unsigned int before = st1 ? network->maxFlow(st1, st2) : network->maxTrains(st2);
+    unsigned int after = st1 ? network->capacityInvestment(st1, st2, budget, upgrades) : network->capacityInvestment(st2, budget, upgrades);
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Capacity Investment ---                        ||" << std::endl;
+    std::cout << "||                     (Segments to Upgrade Within Budget)                   ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Max trains now: " << before << std::endl;
+    std::cout << "  > Max trains after the upgrades: " << after << std::endl;
+    std::cout << std::endl;
+
+    if (upgrades.empty()) std::cout << "  > No upgrade within the budget increases the flow" << std::endl;
+
+    for (auto &u : upgrades) {
+        std::cout << "  > " << u.second->getSrc()->getName() << " - " << u.second->getDest()->getName() << " -> +" << u.first << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
 
 // Button 2 in the main menu
 void service_allocation(){
@@ -624,7 +799,9 @@ void service_allocation(){
      *
      * @details This menu is used to allocate the services of the train network:
      *
-     * [1] Optimal Route - This button calculates the maximum amount of trains that can simultaneously travel between two specific stations with minimum cost for the company.
+     * [1] Optimal Route - This button calculates the maximum amount of trains that can simultaneously travel between two specific stations with minimum cost for the company, the routes they take and, when the network file has them, the distance they travel and the energy they use.
+     *
+     * [2] Trains Within Budget - This button calculates the maximum amount of trains that can travel between two specific stations without exceeding an operating cost budget, and how the min cost grows with the number of trains.
      *
      * [0] Go Back - This button returns to the main menu.
      */
@@ -656,8 +833,8 @@ void service_allocation(){
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||    [1] Optimal Route                                                      ||" << std::endl;
+        std::cout << "||    [2] Trains Within Budget                                               ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                [0] Back   ||" << std::endl;
         std::cout << "\\\\                                                                           //" << std::endl;
@@ -667,6 +844,7 @@ void service_allocation(){
         std::getline(std::cin >> std::ws, option);
 
         if(option == "1") optimal_route();
+        else if(option == "2") budget_trains();
         else if(option == "0") break;
         else{
             clear_screen();
@@ -753,6 +931,75 @@ void optimal_route() {
     std::cout << "  > Max Trains with min cost for the company: " << network->maxCost(st1, st2) << std::endl;
     std::cout << std::endl;
 
+    double distance = 0, energy = 0;
+    std::cout << "  > Routes:" << std::endl;
+    network->trainRoutes(st1, st2, true, [&](const vec<ptr<Link>> &route, int trains) {
+        std::cout << "  > " << trains << " trains: " << route.front()->getSrc()->getName();
+        for (auto &l : route) {
+            std::cout << " -> " << l->getDest()->getName();
+            distance += l->getDistance() * trains;
+            energy += l->getEnergy() * trains;
+        }
+        std::cout << std::endl;
+    });
+    std::cout << std::endl;
+
+    if (distance > 0 || energy > 0) { // only networks with Distance or Energy columns
+        std::cout << "  > Distance travelled by all the trains: " << distance << std::endl;
+        std::cout << "  > Energy used by all the trains: " << energy << std::endl;
+        std::cout << std::endl;
+    }
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
+// Button 2 in the Service Allocation Menu
+void budget_trains() {
+
+    vec<std::pair<long long, long long>> curve;
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                       --- Trains Within Budget ---                        ||" << std::endl;
+    std::cout << "||             (Max Trains Between two Stations for a Given Cost)            ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    ptr<Station> st1, st2;
+    ask_station_pair(st1, st2);
+
+    int budget = ask_number("Operating cost budget");
+    unsigned int trains = network->budgetTrains(st1, st2, budget, curve);
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                       --- Trains Within Budget ---                        ||" << std::endl;
+    std::cout << "||             (Max Trains Between two Stations for a Given Cost)            ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Source Station: " << st1->getName() << std::endl;
+    std::cout << "  > Destination Station: " << st2->getName() << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Max trains within a budget of " << budget << ": " << trains << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Min cost curve:" << std::endl;
+    for (int i = 1; i < (int) curve.size(); i++) {
+        auto [from, low] = curve[i - 1];
+        auto [to, high] = curve[i];
+        std::cout << "  > " << from << " to " << to << " trains: " << low << " to " << high << " ("
+                  << (high - low) / (to - from) << " per train)" << std::endl;
+    }
+    if (curve.size() == 1) std::cout << "  > No train can travel between these stations" << std::endl;
+    std::cout << std::endl;
+
     std::cout << "  > Press Enter to Continue..." << std::endl;
     wait();
 }
@@ -767,6 +1014,10 @@ void failure_forecasting(){
      *
      * [1] Reduced Connectivity - This button calculates the maximum number of trains that can simultaneously travel between two specific stations in a network of reduced connectivity, which is understood as being a subgraph (generated by your system) of the original railway network.
      * [2] Segment Failure Report - This button provides a report on the stations that are the most affected by each segment failure, i.e., the top-k most affected stations for each segment to be considered.
+     * [3] Reliability Estimation - This button estimates, over many random failure scenarios, the distribution of the maximum number of trains between two stations or arriving at a station.
+     * [4] Double Failure Report - This button reports the top-k pairs of segments whose simultaneous failure loses the most trains between two stations or arriving at a station.
+     * [5] Station Failure Report - This button reports the stations whose closure loses the most trains arriving at the rest of the network, with the top-k most affected stations for each one.
+     * [6] Weakest Cut - This button reports the smallest total capacity of segments whose failure splits the network in two, and those segments.
      *
      * [0] Go Back - This button returns to the main menu.
      */
@@ -793,12 +1044,12 @@ void failure_forecasting(){
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
-        std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||    [1] Reduced Connectivity                                               ||" << std::endl;
         std::cout << "||    [2] Segment Failure Report                                             ||" << std::endl;
+        std::cout << "||    [3] Reliability Estimation                                             ||" << std::endl;
+        std::cout << "||    [4] Double Failure Report                                              ||" << std::endl;
+        std::cout << "||    [5] Station Failure Report                                             ||" << std::endl;
+        std::cout << "||    [6] Weakest Cut                                                        ||" << std::endl;
         std::cout << "||                                                                           ||" << std::endl;
         std::cout << "||                                                                [0] Back   ||" << std::endl;
         std::cout << "\\\\                                                                           //" << std::endl;
@@ -809,6 +1060,10 @@ void failure_forecasting(){
 
         if(option == "1") reduced_connectivity();
         else if(option == "2") segment_failure_report();
+        else if(option == "3") reliability_estimation();
+        else if(option == "4") double_failure_report();
+        else if(option == "5") station_failure_report();
+        else if(option == "6") weakest_cut_report();
         else if(option == "0") break;
         else{
             clear_screen();
@@ -1161,6 +1416,202 @@ void segment_failure_report() {
     wait();
 }
 
+// Button 3 in the Failure Forecasting Menu
+void reliability_estimation() {
+
+    ptr<Station> st1, st2;
+    ReliabilityReport report;
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                         (Reliability Estimation)                          ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    ask_flow_or_arrival("Estimate", st1, st2);
+
+    int link_probability = ask_number("Link failure probability (%)");
+    int station_probability = ask_number("Station failure probability (%)");
+    int samples = ask_number("Number of scenarios");
+    int seed = ask_number("Random seed");
+
+    for (auto &l : network->getLinks()) l->setFailureProbability(link_probability / 100.0);
+    for (auto &s : network->getStations()) s->setFailureProbability(station_probability / 100.0);
+
+    auto progress = progress_line("Scenarios evaluated");
+    if (st1) network->reliability(st1, st2, samples, seed, report, progress.get());
+    else network->reliability(st2, samples, seed, report, progress.get());
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                         (Reliability Estimation)                          ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    if (st1) std::cout << "  > Flow between " << st1->getName() << " and " << st2->getName() << std::endl;
+    else std::cout << "  > Trains arriving at " << st2->getName() << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Flow with no failures: " << report.baseline << std::endl;
+    std::cout << "  > Mean flow over " << report.samples << " scenarios: " << report.mean << " (95% CI " << report.low << " - " << report.high << ")" << std::endl;
+    std::cout << "  > Standard deviation: " << report.stddev << std::endl;
+    std::cout << "  > Scenarios with full service: " << report.fullService * 100 << "%" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  > Distribution:" << std::endl;
+    for (auto &p : report.distribution) {
+        std::cout << "  > " << p.first << " trains -> " << p.second << " scenarios" << std::endl;
+    }
+    std::cout << std::endl;
+
+    for (auto &l : network->getLinks()) l->setFailureProbability(0);
+    for (auto &s : network->getStations()) s->setFailureProbability(0);
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
+// Button 4 in the Failure Forecasting Menu
+void double_failure_report() {
+
+    ptr<Station> st1, st2;
+    vec<LinkPairFailure> worst;
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                          (Double Failure Report)                          ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    ask_flow_or_arrival("Report", st1, st2);
+
+    int k = ask_number("Number of segment pairs to be reported");
+
+    auto progress = progress_line("Segments evaluated");
+    auto checkpoint = checkpoint_file();
+    if (st1) network->worstLinkPairs(st1, st2, k, worst, progress.get(), checkpoint.get());
+    else network->worstLinkPairs(st2, k, worst, progress.get(), checkpoint.get());
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                          (Double Failure Report)                          ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    if (st1) std::cout << "  > Top " << k << " segment pairs for the flow between " << st1->getName() << " and " << st2->getName() << ":" << std::endl;
+    else std::cout << "  > Top " << k << " segment pairs for the trains arriving at " << st2->getName() << ":" << std::endl;
+    std::cout << std::endl;
+
+    if (worst.empty()) std::cout << "  > No pair of segments loses more than each segment alone" << std::endl;
+
+    int n = 1;
+    for (auto &w : worst) {
+        std::cout << "  > " << n++ << " " << w.first->getSrc()->getName() << " - " << w.first->getDest()->getName()
+                  << " and " << w.second->getSrc()->getName() << " - " << w.second->getDest()->getName()
+                  << " with " << w.loss << " difference in flow" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
+// Button 5 in the Failure Forecasting Menu
+void station_failure_report() {
+
+    vec<StationFailure> failures;
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                          (Station Failure Report)                         ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    int n_stations = ask_number("Number of station closures to be reported");
+    int k = ask_number("Number of affected stations per closure");
+
+    auto progress = progress_line("Stations evaluated");
+    network->stationFailures(k, failures, progress.get());
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                          (Station Failure Report)                         ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    if (failures.empty()) std::cout << "  > No station closure affects the rest of the network" << std::endl;
+
+    int n = 1;
+    for (auto &f : failures) {
+        if (n > n_stations) break;
+        std::cout << "  > " << n++ << " Closing " << f.station->getName() << " loses " << f.loss << " trains arriving elsewhere" << std::endl;
+        for (auto &a : f.affected) {
+            std::cout << "      - " << network->getStation(a.second)->getName() << " with " << a.first << " difference in flow" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
+// Button 6 in the Failure Forecasting Menu
+void weakest_cut_report() {
+
+    vec<ptr<Link>> cut;
+    vec<ptr<Station>> side;
+    unsigned int capacity = network->globalMinCut(cut, side);
+
+    clear_screen();
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << "//                                                                           \\\\" << std::endl;
+    std::cout << "||                        --- Failure Forecasting ---                        ||" << std::endl;
+    std::cout << "||                     (Weakest Cut - Network Robustness)                    ||" << std::endl;
+    std::cout << "\\\\                                                                           //" << std::endl;
+    std::cout << "  ===========================================================================  " << std::endl;
+    std::cout << std::endl;
+
+    if (side.empty()) std::cout << "  > The network has fewer than two linked stations" << std::endl;
+    else if (cut.empty()) {
+        std::cout << "  > The network is already split: these stations have no segment to the rest" << std::endl;
+        std::cout << std::endl;
+        for (auto &s : side) std::cout << "  > " << s->getName() << std::endl;
+    }
+    else {
+        std::cout << "  > Smallest capacity whose failure splits the network: " << capacity << std::endl;
+        std::cout << "  > Stations cut off on one side: " << side.size() << std::endl;
+        std::cout << std::endl;
+
+        std::cout << "  > Segments of the cut:" << std::endl;
+        for (auto &l : cut) {
+            std::cout << "  > " << l->getSrc()->getName() << " - " << l->getDest()->getName() << " with capacity " << l->getCapacity() << std::endl;
+        }
+    }
+    std::cout << std::endl;
+
+    std::cout << "  > Press Enter to Continue..." << std::endl;
+    wait();
+}
+
 
 void clear_screen(){
     for (int i = 0; i < 50; i++) {
@@ -1183,4 +1634,129 @@ bool is_linked(const std::string& s1, const std::string& s2){
         }
     }
     return false;
-}
\ No newline at end of file
+}
+ptr<Station> ask_station(const std::string& prompt){
+    std::string name;
+    std::cout << "  > Enter the name of the " << prompt << ": ";
+    std::getline(std::cin >> std::ws, name);
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    std::cout << std::endl;
+
+    while (stations.find(name) == stations.end()) {
+        clear_screen();
+        std::cout << "  > The station does not exist!" << std::endl;
+        std::cout << "  > Press Enter to Continue..." << std::endl;
+        wait();
+
+        clear_screen();
+        std::cout << "  > Please enter the name of a existing " << prompt << ": ";
+        std::getline(std::cin >> std::ws, name);
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        std::cout << std::endl;
+    }
+    return stations.at(name);
+}
+
+int ask_number(const std::string& prompt){
+    std::string option;
+    std::cout << "  > " << prompt << ": ";
+    std::getline(std::cin >> std::ws, option);
+    std::cout << std::endl;
+
+    while (!is_number(option)) {
+        clear_screen();
+        std::cout << "  > Invalid option!" << std::endl;
+        std::cout << "  > Press Enter to Continue..." << std::endl;
+        wait();
+
+        clear_screen();
+        std::cout << "  > " << prompt << ": ";
+        std::getline(std::cin >> std::ws, option);
+        std::cout << std::endl;
+    }
+    return std::stoi(option);
+}
+
+void ask_station_pair(ptr<Station>& st1, ptr<Station>& st2){
+    st1 = ask_station("source station");
+    do st2 = ask_station("destination station, different from the source,"); while (st2 == st1);
+}
+
+void ask_flow_or_arrival(const std::string& action, ptr<Station>& st1, ptr<Station>& st2){
+    std::string option;
+    std::cout << "  > " << action << " [1] Flow Between Stations or [2] Arrival at a Station: ";
+    std::getline(std::cin >> std::ws, option);
+    std::cout << std::endl;
+
+    while (option != "1" && option != "2") {
+        clear_screen();
+        std::cout << "  > Invalid option!" << std::endl;
+        std::cout << "  > Press Enter to Continue..." << std::endl;
+        wait();
+
+        clear_screen();
+        std::cout << "  > Please enter [1] for Flow Between Stations or [2] for Arrival at a Station: ";
+        std::getline(std::cin >> std::ws, option);
+        std::cout << std::endl;
+    }
+
+    st1 = nullptr;
+    if (option == "1") ask_station_pair(st1, st2);
+    else st2 = ask_station("station");
+}
+
+StationOrder station_order(){
+    const char *order = std::getenv("RAILWAYS_ORDER");
+    std::string name = order ? order : "";
+    if (name == "bfs") return BFS_ORDER;
+    if (name == "rcm") return RCM_ORDER;
+    if (name == "district") return DISTRICT_ORDER;
+    return INPUT_ORDER;
+}
+
+void load_graph(bool partial){
+    NetworkBuilder builder;
+    builder.setOrder(station_order());
+    stations_file = partial ? "../data/partial_stations.csv" : "../data/stations.csv";
+    links_file = partial ? "../data/partial_network.csv" : "../data/network.csv";
+    if (partial) readPartialStations(builder);
+    else readStations(builder);
+    readLinks(builder, links_file);
+    network = builder.build();
+}
+
+bool prepare_flow_matrix(bool *computed){
+    uint64_t checksum = FlowMatrix::fileChecksum({stations_file, links_file});
+    std::string path = links_file.substr(0, links_file.rfind('.')) + ".flows";
+    bool loaded = matrix.load(path, checksum);
+    if (computed) *computed = !loaded;
+    if (loaded) return true;
+    matrix.build(*network, checksum); // missing or stale
+    return matrix.save(path);
+}
+
+const FlowMatrix& flow_matrix(){
+    return matrix;
+}
+
+ptr<Station> station_by_input_id(int id){
+    for (auto &s : network->getStations())
+        if (network->getInputId(s->getId()) == id) return s;
+    return nullptr;
+}
+
+ptr<Progress> progress_line(const std::string& what){
+    auto progress = make<Progress>([what](long long done, long long total, long long) {
+        std::cout << "\r  > " << what << ": " << done << " of " << total << std::flush;
+        if (done >= total) std::cout << std::endl;
+    });
+    const char *timeout = std::getenv("RAILWAYS_TIMEOUT"); // milliseconds, for unattended runs
+    if (timeout && is_number(timeout)) progress->setDeadline(std::chrono::milliseconds(std::stoll(timeout)));
+    return progress;
+}
+
+ptr<Checkpoint> checkpoint_file(){
+    const char *path = std::getenv("RAILWAYS_CHECKPOINT"); // file to resume long sweeps from
+    if (!path || !*path) return nullptr;
+    return make<Checkpoint>(path);
+}